@@ -0,0 +1,240 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+/**
+* Standalone harness for the capture scheduling core (RenderDocPluginCaptureScheduler.h):
+* replays millions of synthetic engine frames, with a deterministic fake clock and
+* frame counters, a fake RenderDoc backend and a pseudo-random (but seeded)
+* pattern of frame, range and startup capture requests. Every capture is checked
+* against the scheduling rules, and the time per frame of the whole replay (fake
+* engine and backend included) is reported.
+* No engine is needed; on Linux (or with any C++11 compiler):
+*
+*   g++ -std=c++11 -O2 -I../../Source/RenderDocPlugin/Private -o CaptureSchedulerBench CaptureSchedulerBench.cpp
+*   ./CaptureSchedulerBench [frames=10000000] [seed=1]
+*
+* The exit code is the number of violations found (0 on success); the event hash
+* is identical from one run to the next for a given seed.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+// The only engine types the core relies on:
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+
+#include "RenderDocPluginCaptureScheduler.h"
+
+// Fixed 60 Hz clock, advanced by the harness once per engine frame:
+class FFakeClock : public IRenderDocCaptureClock
+{
+public:
+	FFakeClock() : Seconds(0.0) { }
+	virtual double GetSeconds() const override { return(Seconds); }
+	double Seconds;
+};
+
+class FFakeFrameSource : public IRenderDocFrameSource
+{
+public:
+	FFakeFrameSource() : EngineFrame(1), RenderFrame(1) { }
+	virtual uint64 GetEngineFrame() const override { return(EngineFrame); }
+	virtual uint64 GetRenderFrame() const override { return(RenderFrame); }
+	uint64 EngineFrame;
+	uint64 RenderFrame;
+};
+
+// Plays RenderDoc, and checks what the scheduler asks of it:
+class FFakeBackend : public IRenderDocCaptureBackend
+{
+public:
+	FFakeBackend(const FFakeFrameSource& InFrames)
+		: Frames(InFrames), AdmitCount(0), Captures(0), CapturedFrames(0), Refused(0)
+		, Violations(0), bCapturing(false), BeginFrame(0), Hash(1469598103934665603ull)
+	{ }
+
+	virtual bool AdmitScheduledCapture(const FRenderDocCaptureRequest&) override
+	{
+		// Plays the memory guard, refusing one capture out of 13:
+		if ((++AdmitCount % 13) == 0)
+		{
+			++Refused;
+			return(false);
+		}
+		return(true);
+	}
+
+	virtual void BeginScheduledCapture(const FRenderDocCaptureRequest& Request) override
+	{
+		Check(!bCapturing, "capture begun while another one is in progress");
+		Check(Request.StartFrame == Frames.EngineFrame, "capture start frame is not the current engine frame");
+		Check(Request.StartFrame >= Request.RequestedFrame, "capture begun before its request");
+		if (Request.Kind == FRenderDocCaptureRequest::Frame || Request.Kind == FRenderDocCaptureRequest::Range)
+			Check(Request.StartFrame <= Request.RequestedFrame + 1, "capture did not begin at the next frame boundary");
+		if (Request.Kind == FRenderDocCaptureRequest::StartupFrame)
+			Check(Request.RenderFrame >= Request.TargetRenderFrame, "startup frame captured too early");
+
+		bCapturing = true;
+		BeginFrame = Frames.EngineFrame;
+		Mix(1 + Request.Kind);
+		Mix(Frames.EngineFrame);
+	}
+
+	virtual void EndScheduledCapture(const FRenderDocCaptureRequest& Request, uint64 InFrames, double Seconds) override
+	{
+		Check(bCapturing, "capture ended without having begun");
+		Check(InFrames == Frames.EngineFrame - BeginFrame || (InFrames == 1 && Frames.EngineFrame == BeginFrame), "wrong number of captured frames");
+		switch (Request.Kind)
+		{
+		case FRenderDocCaptureRequest::Frame :
+		case FRenderDocCaptureRequest::StartupFrame :
+			Check(InFrames == 1 && Frames.EngineFrame == BeginFrame, "frame capture did not span exactly one engine tick");
+			break;
+		default :
+			Check(Request.MaxFrames == 0 || InFrames <= Request.MaxFrames, "range capture went past its frame cap");
+			break;
+		}
+		Check(Seconds >= 0.0, "negative capture duration");
+
+		bCapturing = false;
+		++Captures;
+		CapturedFrames += InFrames;
+		Mix(100 + Request.Kind);
+		Mix(Frames.EngineFrame);
+	}
+
+	void Check(bool bCondition, const char* What)
+	{
+		if (bCondition)
+			return;
+		if (Violations < 10)
+			fprintf(stderr, "frame %llu: %s\n", (unsigned long long)Frames.EngineFrame, What);
+		++Violations;
+	}
+
+	// FNV-1a over the sequence of scheduled events:
+	void Mix(uint64 Value)
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			Hash ^= (Value >> (i * 8)) & 0xFF;
+			Hash *= 1099511628211ull;
+		}
+	}
+
+	const FFakeFrameSource& Frames;
+	uint64 AdmitCount;
+	uint64 Captures;
+	uint64 CapturedFrames;
+	uint64 Refused;
+	uint64 Violations;
+	bool bCapturing;
+	uint64 BeginFrame;
+	uint64 Hash;
+};
+
+// xorshift64*; deterministic for a given seed, on every platform:
+static uint64 Random(uint64& State)
+{
+	State ^= State >> 12;
+	State ^= State << 25;
+	State ^= State >> 27;
+	return(State * 2685821657736338717ull);
+}
+
+int main(int argc, char** argv)
+{
+	const uint64 NumFrames = (argc > 1) ? strtoull(argv[1], NULL, 10) : 10000000ull;
+	uint64 State = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1ull;
+	State = State ? State : 1ull;
+
+	FFakeClock Clock;
+	FFakeFrameSource Frames;
+	FFakeBackend Backend (Frames);
+	FRenderDocPluginCaptureScheduler Scheduler (Clock, Frames, Backend);
+
+	Scheduler.ArmStartupFrame(120);
+	Scheduler.ArmFirstFrames(30);
+
+	uint64 Requests (0);
+	uint64 Accepted (0);
+	// Timed as a whole: reading the clock around every frame would cost about as much
+	// as the scheduler itself.
+	const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	for (uint64 i = 0; i < NumFrames; ++i)
+	{
+		// Request pattern, as issued by the plugin features during the tick:
+		const uint64 Roll = Random(State) % 10000;
+		if (Roll < 50)
+		{
+			++Requests;
+			Accepted += Scheduler.RequestFrame() ? 1 : 0;
+		}
+		else if (Roll < 55)
+		{
+			++Requests;
+			Accepted += Scheduler.BeginRange((uint32)(Random(State) % 600)) ? 1 : 0;
+		}
+		else if (Roll < 80)
+		{
+			Scheduler.EndRange();
+		}
+		else if (Roll < 81)
+		{
+			Scheduler.ArmFirstFrames((uint32)(1 + Random(State) % 60));
+		}
+		else if (Roll < 82)
+		{
+			Scheduler.ArmStartupFrame(Frames.RenderFrame + Random(State) % 1000);
+		}
+
+		// Once in a while, a viewport or scoped capture delays the startup ones:
+		Scheduler.OnBeginFrame((Roll % 97) == 0);
+		Scheduler.OnEndFrame();
+
+		// Several frames get rendered in some engine ticks:
+		++Frames.EngineFrame;
+		Frames.RenderFrame += 1 + ((Roll % 31) == 0 ? 1 : 0);
+		Clock.Seconds += 1.0 / 60.0;
+	}
+	const double LoopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+	Scheduler.EndRange();
+	Scheduler.OnBeginFrame();
+	Scheduler.OnEndFrame();
+	Backend.Check(!Backend.bCapturing, "capture still in progress at the end of the run");
+	Backend.Check(Scheduler.IsIdle(), "scheduler not idle at the end of the run");
+
+	printf("frames:          %llu\n", (unsigned long long)NumFrames);
+	printf("requests:        %llu (%llu accepted, %llu refused by the backend)\n", (unsigned long long)Requests, (unsigned long long)Accepted, (unsigned long long)Backend.Refused);
+	printf("captures:        %llu (%llu frames captured)\n", (unsigned long long)Backend.Captures, (unsigned long long)Backend.CapturedFrames);
+	printf("loop time:       %.3f s (%.1f ns per frame, harness included)\n", LoopSeconds, LoopSeconds * 1e9 / (double)(NumFrames ? NumFrames : 1));
+	printf("event hash:      %016llx\n", (unsigned long long)Backend.Hash);
+	printf("violations:      %llu\n", (unsigned long long)Backend.Violations);
+	return((int)(Backend.Violations < 255 ? Backend.Violations : 255));
+}
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+#
+# Sends and listens to synchronized capture requests (see
+# RenderDocPluginCaptureSync.h), without the engine; e.g. to drive a dedicated
+# server and a few clients started with -RenderDocSync on the same machine:
+#
+#   python3 CaptureSync.py send [lead seconds=1.0]
+#   python3 CaptureSync.py listen
+#
+# The group and port default to the plugin ones (CaptureSyncGroup/CaptureSyncPort).
+
+import argparse
+import os
+import socket
+import struct
+import time
+
+MAGIC = "RDSYNC1"
+
+
+def open_socket(group, port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, "SO_REUSEPORT"):
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+    return sock
+
+
+def send(group, port, lead, sequence):
+    sock = open_socket(group, port)
+    # No server world time from outside the engine; members go by the UTC clock:
+    message = "%s %08x %u %.6f %.6f" % (MAGIC, os.getpid(), sequence, time.time() + lead, -1.0)
+    for _ in range(3):
+        sock.sendto(message.encode("utf-8"), (group, port))
+    print(message)
+
+
+def listen(group, port):
+    sock = open_socket(group, port)
+    sock.bind(("", port))
+    membership = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton("0.0.0.0"))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    last = None
+    while True:
+        data, sender = sock.recvfrom(256)
+        tokens = data.decode("utf-8", "replace").split()
+        if len(tokens) != 5 or tokens[0] != MAGIC or tokens[1:3] == last:
+            continue
+        last = tokens[1:3]
+        print("%s:%d request %s-%s due in %.3f s (server world time %s)" % (
+            sender[0], sender[1], tokens[1], tokens[2], float(tokens[3]) - time.time(), tokens[4]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RenderDoc plugin synchronized capture requests")
+    parser.add_argument("--group", default="230.0.0.1")
+    parser.add_argument("--port", type=int, default=6680)
+    commands = parser.add_subparsers(dest="command")
+    send_parser = commands.add_parser("send", help="broadcast a capture request")
+    send_parser.add_argument("lead", type=float, nargs="?", default=1.0)
+    send_parser.add_argument("--sequence", type=int, default=1)
+    commands.add_parser("listen", help="print the requests sent to the group")
+    args = parser.parse_args()
+
+    if args.command == "send":
+        send(args.group, args.port, args.lead, args.sequence)
+    elif args.command == "listen":
+        listen(args.group, args.port)
+    else:
+        parser.print_help()
+
+
+if __name__ == "__main__":
+    main()
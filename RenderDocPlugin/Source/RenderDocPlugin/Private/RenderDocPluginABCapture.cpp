@@ -0,0 +1,410 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginABCapture.h"
+
+#include "RenderDocPluginModule.h"
+
+#include "Kismet/GameplayStatics.h"
+#include "ShaderCompiler.h"
+#include "Json.h"
+
+static const TCHAR* SideNames [2] = { TEXT("A"), TEXT("B") };
+
+// Frames to wait for the ProfileGPU dump before giving up (no GPU profiling on this RHI):
+static const int32 ProfileTimeoutFrames = 120;
+
+FRenderDocPluginABCapture::FRenderDocPluginABCapture()
+	: State(Idle)
+	, Side(0)
+	, StateFrames(0)
+	, StateStartTime(0.0)
+	, ProfileLinesSeen(0)
+	, bProfileUIWasShown(false)
+	, ProfileUISetBy(ECVF_SetByConstructor)
+	, SettleFrames(10)
+	, SettleTimeout(60.0f)
+	, CaptureTimeout(120.0f)
+{
+	if (!GConfig)
+		return;
+
+	GConfig->GetInt  (TEXT("RenderDoc"), TEXT("ABCaptureSettleFrames"),  SettleFrames,  GGameIni);
+	GConfig->GetFloat(TEXT("RenderDoc"), TEXT("ABCaptureSettleTimeout"), SettleTimeout, GGameIni);
+	GConfig->GetFloat(TEXT("RenderDoc"), TEXT("ABCaptureTimeout"),       CaptureTimeout, GGameIni);
+	SettleFrames = FMath::Max(1, SettleFrames);
+}
+
+bool FRenderDocPluginABCapture::Start(const TArray<FString>& Args)
+{
+	if (IsRunning())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture: already running"));
+		return(false);
+	}
+
+	if (Args.Num() == 0 || (Args.Num() % 3) != 0)
+	{
+		UE_LOG(RenderDocPlugin, Error, TEXT("A/B capture: expected <console variable> <A value> <B value> triplets"));
+		return(false);
+	}
+
+	Variables.Empty();
+	for (int32 i = 0; i < Args.Num(); i += 3)
+	{
+		IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(*Args[i]);
+		if (!Variable)
+		{
+			UE_LOG(RenderDocPlugin, Error, TEXT("A/B capture: unknown console variable '%s'"), *Args[i]);
+			return(false);
+		}
+
+		FVariable& Entry = Variables[Variables.AddDefaulted()];
+		Entry.Name = Args[i];
+		Entry.Variable = Variable;
+		Entry.Original = Variable->GetString();
+		Entry.OriginalSetBy = (EConsoleVariableFlags)(Variable->GetFlags() & ECVF_SetByMask);
+		Entry.Values[0] = Args[i + 1];
+		Entry.Values[1] = Args[i + 2];
+	}
+
+	for (FSide& Result : Sides)
+		Result = FSide();
+	Stamp = FDateTime::Now().ToString();
+
+	// The GPU visualizer would pop up after each profile, in the Editor:
+	bProfileUIWasShown = false;
+	if (IConsoleVariable* ShowUI = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ProfileGPU.ShowUI")))
+	{
+		bProfileUIWasShown = (ShowUI->GetInt() != 0);
+		ProfileUISetBy = (EConsoleVariableFlags)(ShowUI->GetFlags() & ECVF_SetByMask);
+		ShowUI->Set(0, ECVF_SetByConsole);
+	}
+
+	PauseWorlds();
+	ApplySide(0);
+	return(true);
+}
+
+void FRenderDocPluginABCapture::ApplySide(int32 InSide)
+{
+	Side = InSide;
+	for (const FVariable& Entry : Variables)
+		Entry.Variable->Set(*Entry.Values[Side], ECVF_SetByConsole);
+
+	UE_LOG(RenderDocPlugin, Log, TEXT("A/B capture: configuration %s applied; waiting for it to settle"), SideNames[Side]);
+	State = Settling;
+	StateFrames = 0;
+	StateStartTime = FPlatformTime::Seconds();
+}
+
+void FRenderDocPluginABCapture::PauseWorlds()
+{
+	PausedWorlds.Empty();
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		UWorld* World = Context.World();
+		if (!World || World->IsPaused())
+			continue;
+
+		if (Context.WorldType == EWorldType::PIE)
+			World->bDebugPauseExecution = true;
+		else if (Context.WorldType != EWorldType::Game || !UGameplayStatics::SetGamePaused(World, true))
+			continue;
+		PausedWorlds.Add(World);
+	}
+
+	if (PausedWorlds.Num() == 0)
+		UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture: no game world could be paused; the two captures may show different frames"));
+}
+
+void FRenderDocPluginABCapture::ResumeWorlds()
+{
+	for (const TWeakObjectPtr<UWorld>& World : PausedWorlds)
+	{
+		if (!World.IsValid())
+			continue;
+
+		if (World->IsPlayInEditor())
+			World->bDebugPauseExecution = false;
+		else
+			UGameplayStatics::SetGamePaused(World.Get(), false);
+	}
+	PausedWorlds.Empty();
+}
+
+void FRenderDocPluginABCapture::RestoreVariable(IConsoleVariable* Variable, const FString& Value, EConsoleVariableFlags SetBy)
+{
+	// A console variable refuses values set with a lower priority than its last
+	// one, so drop back to the lowest first; the original value then comes back
+	// with its original priority (the device profile, an ini file, ...):
+	Variable->ClearFlags(ECVF_SetByMask);
+	Variable->Set(*Value, SetBy);
+}
+
+bool FRenderDocPluginABCapture::Tick(FString& OutCaptureLabel)
+{
+	switch (State)
+	{
+	case Idle :
+		return(false);
+
+	case Capturing :
+		// The paused world and the console variables are not left as they are if
+		// the capture never comes back:
+		if ((FPlatformTime::Seconds() - StateStartTime) > CaptureTimeout)
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture: no capture of configuration %s within %.0f seconds; giving up"), SideNames[Side], CaptureTimeout);
+			Cancel();
+		}
+		return(false);
+
+	case Settling :
+	{
+		// Some console variables only take effect a few frames later, or trigger
+		// shader recompilations:
+		++StateFrames;
+		const bool bCompiling = GShaderCompilingManager && GShaderCompilingManager->IsCompiling();
+		const bool bSettled = (StateFrames >= SettleFrames) && !bCompiling;
+		const bool bTimedOut = (FPlatformTime::Seconds() - StateStartTime) > SettleTimeout;
+		if (!bSettled && !bTimedOut)
+			return(false);
+
+		if (!bSettled)
+			UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture: configuration %s did not settle within %.0f seconds"), SideNames[Side], SettleTimeout);
+
+		Sides[Side].bSettled = bSettled;
+		CaptureLabel = FString::Printf(TEXT("AB_%s_%s"), *Stamp, SideNames[Side]);
+		OutCaptureLabel = CaptureLabel;
+		State = Capturing;
+		StateStartTime = FPlatformTime::Seconds();
+		return(true);
+	}
+
+	case Profiling :
+	{
+		// The event tree is dumped a few frames after the profiled one, all at once:
+		int32 NumLines;
+		{
+			FScopeLock Lock (&ProfileLock);
+			NumLines = ProfileLines.Num();
+		}
+		const bool bDumped = (NumLines > 0) && (NumLines == ProfileLinesSeen);
+		ProfileLinesSeen = NumLines;
+		if (!bDumped && ++StateFrames < ProfileTimeoutFrames)
+			return(false);
+
+		GLog->RemoveOutputDevice(this);
+		if (!bDumped)
+			UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture: no GPU profile for configuration %s (is GPU profiling supported by this RHI?)"), SideNames[Side]);
+		ParseProfile();
+
+		if (Side == 0)
+			ApplySide(1);
+		else
+			Finish();
+		return(false);
+	}
+	}
+
+	return(false);
+}
+
+void FRenderDocPluginABCapture::OnCaptureEvent(const FRenderDocPluginEvent& Event)
+{
+	if (State != Capturing || Event.Label != CaptureLabel)
+		return;
+
+	if (Event.Stage == ERenderDocCaptureStage::Finished)
+	{
+		Sides[Side].CaptureFile = Event.CaptureFile;
+		Sides[Side].CaptureSize = IFileManager::Get().FileSize(*Event.CaptureFile);
+	}
+	else if (Event.Stage != ERenderDocCaptureStage::Failed)
+	{
+		return;
+	}
+
+	if (Sides[Side].CaptureFile.IsEmpty())
+		UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture: no capture for configuration %s"), SideNames[Side]);
+
+	// Profile the same view, now that RenderDoc is out of the way; with the world
+	// paused, the frame profiled (a later one) shows the same scene:
+	{
+		FScopeLock Lock (&ProfileLock);
+		ProfileLines.Empty();
+	}
+	ProfileLinesSeen = 0;
+	GLog->AddOutputDevice(this);
+	GEngine->Exec(NULL, TEXT("ProfileGPU"));
+	State = Profiling;
+	StateFrames = 0;
+}
+
+void FRenderDocPluginABCapture::Serialize(const TCHAR* Message, ELogVerbosity::Type Verbosity, const FName& Category)
+{
+	static const FName LogRHI (TEXT("LogRHI"));
+	if (State != Profiling || Category != LogRHI)
+		return;
+
+	FScopeLock Lock (&ProfileLock);
+	ProfileLines.Add(Message);
+}
+
+void FRenderDocPluginABCapture::ParseProfile()
+{
+	FSide& Result = Sides[Side];
+
+	TArray<FString> Lines;
+	{
+		FScopeLock Lock (&ProfileLock);
+		Lines = MoveTemp(ProfileLines);
+	}
+
+	// Event tree lines look like "<indent><percent>%<time>ms   <event> <n> draws <n> prims <n> verts";
+	// passes are keyed by their path in the tree, and repeated events are summed:
+	TArray<int32> ParentIndents;
+	TArray<FString> ParentPaths;
+	for (const FString& Line : Lines)
+	{
+		const int32 PercentAt = Line.Find(TEXT("%"));
+		const int32 MsAt = Line.Find(TEXT("ms "), ESearchCase::CaseSensitive);
+		const int32 DrawsAt = Line.Find(TEXT(" draws "), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+		if (PercentAt == INDEX_NONE || MsAt == INDEX_NONE || DrawsAt == INDEX_NONE || !(PercentAt < MsAt && MsAt < DrawsAt))
+			continue;
+
+		FString NameAndDraws = Line.Mid(MsAt + 3, DrawsAt - MsAt - 3).Trim().TrimTrailing();
+		int32 SpaceAt;
+		if (!NameAndDraws.FindLastChar(TEXT(' '), SpaceAt))
+			continue;
+
+		const int32 Indent = Line.Len() - Line.Trim().Len();
+		while (ParentIndents.Num() > 0 && ParentIndents.Last() >= Indent)
+		{
+			ParentIndents.Pop();
+			ParentPaths.Pop();
+		}
+		FString Path = NameAndDraws.Left(SpaceAt).TrimTrailing();
+		if (ParentPaths.Num() > 0)
+			Path = ParentPaths.Last() + TEXT("/") + Path;
+		ParentIndents.Add(Indent);
+		ParentPaths.Add(Path);
+
+		FPassStats* Stats = Result.Passes.Find(Path);
+		if (!Stats)
+		{
+			Result.PassOrder.Add(Path);
+			Stats = &Result.Passes.Add(Path, FPassStats());
+			Stats->Draws = Stats->Primitives = 0;
+			Stats->GPUMs = 0.0f;
+		}
+		Stats->Draws      += FCString::Atoi(*NameAndDraws.Mid(SpaceAt + 1));
+		Stats->Primitives += FCString::Atoi(*Line.Mid(DrawsAt + 7));
+		Stats->GPUMs      += FCString::Atof(*Line.Mid(PercentAt + 1, MsAt - PercentAt - 1));
+	}
+}
+
+void FRenderDocPluginABCapture::WriteManifest()
+{
+	FString Json;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+
+	Writer->WriteValue(TEXT("engine"), FEngineVersion::Current().ToString());
+	Writer->WriteValue(TEXT("date"), FDateTime::Now().ToIso8601());
+
+	for (int32 i = 0; i < 2; ++i)
+	{
+		Writer->WriteObjectStart(SideNames[i]);
+		Writer->WriteObjectStart(TEXT("cvars"));
+		for (const FVariable& Entry : Variables)
+			Writer->WriteValue(Entry.Name, Entry.Values[i]);
+		Writer->WriteObjectEnd();
+		Writer->WriteValue(TEXT("capture"), Sides[i].CaptureFile);
+		Writer->WriteValue(TEXT("captureBytes"), (double)Sides[i].CaptureSize);
+		Writer->WriteValue(TEXT("settled"), Sides[i].bSettled);
+		Writer->WriteObjectEnd();
+	}
+
+	// Passes of A first, in tree order, then the ones only B has:
+	TArray<FString> PassOrder = Sides[0].PassOrder;
+	for (const FString& Pass : Sides[1].PassOrder)
+		PassOrder.AddUnique(Pass);
+
+	Writer->WriteArrayStart(TEXT("passes"));
+	for (const FString& Pass : PassOrder)
+	{
+		const FPassStats* A = Sides[0].Passes.Find(Pass);
+		const FPassStats* B = Sides[1].Passes.Find(Pass);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("pass"), Pass);
+		Writer->WriteValue(TEXT("drawsA"), A ? A->Draws : 0);
+		Writer->WriteValue(TEXT("drawsB"), B ? B->Draws : 0);
+		Writer->WriteValue(TEXT("primitivesA"), A ? A->Primitives : 0);
+		Writer->WriteValue(TEXT("primitivesB"), B ? B->Primitives : 0);
+		Writer->WriteValue(TEXT("gpuMsA"), A ? A->GPUMs : 0.0f);
+		Writer->WriteValue(TEXT("gpuMsB"), B ? B->GPUMs : 0.0f);
+		Writer->WriteObjectEnd();
+
+		if (!A || !B || A->Draws != B->Draws)
+			UE_LOG(RenderDocPlugin, Log, TEXT("A/B capture: %s: %d -> %d draws"), *Pass, A ? A->Draws : 0, B ? B->Draws : 0);
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	const FString ManifestFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(*FPaths::GameSavedDir(), TEXT("RenderDocCaptures"),
+		*FString::Printf(TEXT("AB_%s.json"), *Stamp)));
+	if (FFileHelper::SaveStringToFile(Json, *ManifestFile))
+		UE_LOG(RenderDocPlugin, Log, TEXT("A/B capture: manifest written to '%s'"), *ManifestFile);
+	else
+		UE_LOG(RenderDocPlugin, Error, TEXT("A/B capture: unable to write manifest '%s'"), *ManifestFile);
+}
+
+void FRenderDocPluginABCapture::Finish()
+{
+	WriteManifest();
+	Cancel();
+	UE_LOG(RenderDocPlugin, Log, TEXT("A/B capture: done"));
+}
+
+void FRenderDocPluginABCapture::Cancel()
+{
+	if (!IsRunning())
+		return;
+
+	if (State == Profiling)
+		GLog->RemoveOutputDevice(this);
+
+	for (const FVariable& Entry : Variables)
+		RestoreVariable(Entry.Variable, Entry.Original, Entry.OriginalSetBy);
+	if (IConsoleVariable* ShowUI = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ProfileGPU.ShowUI")))
+		RestoreVariable(ShowUI, bProfileUIWasShown ? TEXT("1") : TEXT("0"), ProfileUISetBy);
+
+	ResumeWorlds();
+	State = Idle;
+}
@@ -0,0 +1,134 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#include "RenderDocPluginEvents.h"
+
+/**
+* A/B capture: two captures of the same frame under two render configurations,
+* to check the effect of an optimization. The game is paused, the console
+* variables are set to their A values, a frame is captured, then the same with
+* the B values, and finally the console variables and the pause state are
+* restored.
+*
+* After each capture, the same frame is also profiled with the engine GPU profiler
+* (ProfileGPU), whose per-pass draw counts are collected from the log. A paired
+* JSON manifest lists both captures (file, size, console variable values) and the
+* per-pass comparison of draw and primitive counts and GPU times:
+*
+*   <Game>/Saved/RenderDocCaptures/AB_<date>.json
+*/
+class FRenderDocPluginABCapture : public FOutputDevice
+{
+public:
+	FRenderDocPluginABCapture();
+
+	/**
+	* Starts an A/B capture.
+	* @param Args Triplets of console variable name, A value and B value.
+	* @return False if the arguments are invalid, or an A/B capture is already running.
+	*/
+	bool Start(const TArray<FString>& Args);
+
+	/** Restores the console variables and the pause state right away. */
+	void Cancel();
+
+	bool IsRunning() const { return(State != Idle); }
+
+	/**
+	* To be called once per engine tick, on the game thread. Returns true when the
+	* current configuration has settled and the next frame must be captured, along
+	* with the label of that capture.
+	*/
+	bool Tick(FString& CaptureLabel);
+
+	/** Listens to capture progress, to learn about the capture of each side. */
+	void OnCaptureEvent(const FRenderDocPluginEvent& Event);
+
+	// FOutputDevice; collects the ProfileGPU event tree while profiling:
+	virtual void Serialize(const TCHAR* Message, ELogVerbosity::Type Verbosity, const FName& Category) override;
+
+private:
+	struct FVariable
+	{
+		FString Name;
+		IConsoleVariable* Variable;
+		FString Original;
+		EConsoleVariableFlags OriginalSetBy;
+		FString Values [2];
+	};
+
+	struct FPassStats
+	{
+		int32 Draws;
+		int32 Primitives;
+		float GPUMs;
+	};
+
+	struct FSide
+	{
+		FString CaptureFile;
+		int64 CaptureSize;
+		bool bSettled;
+		TArray<FString> PassOrder;
+		TMap<FString, FPassStats> Passes;
+
+		FSide() : CaptureSize(-1), bSettled(false) { }
+	};
+
+	enum EState { Idle, Settling, Capturing, Profiling };
+
+	void ApplySide(int32 InSide);
+	void PauseWorlds();
+	void ResumeWorlds();
+	static void RestoreVariable(IConsoleVariable* Variable, const FString& Value, EConsoleVariableFlags SetBy);
+	void ParseProfile();
+	void WriteManifest();
+	void Finish();
+
+	EState State;
+	int32 Side;
+	FString Stamp;
+	FString CaptureLabel;
+	TArray<FVariable> Variables;
+	FSide Sides [2];
+	TArray< TWeakObjectPtr<UWorld> > PausedWorlds;
+
+	int32 StateFrames;
+	double StateStartTime;
+
+	// ProfileGPU output of the current side (log lines may come from any thread):
+	FCriticalSection ProfileLock;
+	TArray<FString> ProfileLines;
+	int32 ProfileLinesSeen;
+	bool bProfileUIWasShown;
+	EConsoleVariableFlags ProfileUISetBy;
+
+	// Tunables, from the [RenderDoc] section of the game config:
+	int32 SettleFrames;
+	float SettleTimeout;
+	float CaptureTimeout;
+};
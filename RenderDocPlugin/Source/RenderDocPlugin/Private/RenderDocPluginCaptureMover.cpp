@@ -0,0 +1,193 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginCaptureMover.h"
+
+#include "RenderDocPluginModule.h"
+
+#include "SecureHash.h"
+
+static const int32 CopyBlockSize = 1024 * 1024;
+
+// Progress is reported every so many bytes copied:
+static const int64 ProgressInterval = 16 * 1024 * 1024;
+
+static bool HashFile(const FString& File, uint8 (&Digest) [16])
+{
+	TUniquePtr<FArchive> Reader (IFileManager::Get().CreateFileReader(*File));
+	if (!Reader)
+		return(false);
+
+	TArray<uint8> Block;
+	Block.SetNumUninitialized(CopyBlockSize);
+
+	FMD5 MD5;
+	int64 Remaining = Reader->TotalSize();
+	while (Remaining > 0)
+	{
+		const int32 BlockSize = (int32)FMath::Min<int64>(Remaining, CopyBlockSize);
+		Reader->Serialize(Block.GetData(), BlockSize);
+		MD5.Update(Block.GetData(), BlockSize);
+		Remaining -= BlockSize;
+	}
+	MD5.Final(Digest);
+	return(!Reader->IsError());
+}
+
+FRenderDocPluginCaptureMover::FRenderDocPluginCaptureMover(const FString& InScratchDirectory, const FString& InDestinationDirectory, FRenderDocPluginEventChannel* InEvents)
+	: ScratchDirectory(InScratchDirectory)
+	, DestinationDirectory(InDestinationDirectory)
+	, Events(InEvents)
+{
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("RenderDocCaptureMover"), 0, TPri_Lowest);
+}
+
+FRenderDocPluginCaptureMover::~FRenderDocPluginCaptureMover()
+{
+	if (Thread)
+	{
+		// Captures still queued stay in the scratch directory and are picked up
+		// again by EnqueueLeftovers() next time:
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+}
+
+void FRenderDocPluginCaptureMover::Enqueue(const FString& CaptureFile, const FString& Label, TFunction<void(const FString&)> OnMoved)
+{
+	Jobs.Enqueue({ CaptureFile, Label, MoveTemp(OnMoved) });
+	WorkEvent->Trigger();
+}
+
+void FRenderDocPluginCaptureMover::EnqueueLeftovers(TFunction<void(const FString&)> OnMoved)
+{
+	// Long enough for any running session to have written (and migrated) its captures:
+	static const FTimespan MinLeftoverAge = FTimespan::FromMinutes(15.0);
+
+	TArray<FString> Captures;
+	IFileManager::Get().FindFiles(Captures, *FPaths::Combine(*ScratchDirectory, TEXT("*.log")), true, false);
+	for (const FString& Capture : Captures)
+	{
+		const FString CaptureFile = FPaths::Combine(*ScratchDirectory, *Capture);
+		const FDateTime Modified = IFileManager::Get().GetTimeStamp(*CaptureFile);
+		if (Modified == FDateTime::MinValue() || (FDateTime::UtcNow() - Modified) < MinLeftoverAge)
+			continue;
+
+		UE_LOG(RenderDocPlugin, Log, TEXT("capture mover: recovering '%s' from the scratch directory"), *Capture);
+		Enqueue(CaptureFile, FString(), OnMoved);
+	}
+}
+
+uint32 FRenderDocPluginCaptureMover::Run()
+{
+	while (StopRequested.GetValue() == 0)
+	{
+		FJob Job;
+		while ((StopRequested.GetValue() == 0) && Jobs.Dequeue(Job))
+		{
+			const FString Destination = FPaths::Combine(*DestinationDirectory, *FPaths::GetCleanFilename(Job.CaptureFile));
+			const bool bMoved = MoveCapture(Job.CaptureFile, Destination, Job.Label);
+			if (Job.OnMoved)
+				Job.OnMoved(bMoved ? Destination : FString());
+		}
+		WorkEvent->Wait();
+	}
+	return(0);
+}
+
+void FRenderDocPluginCaptureMover::Stop()
+{
+	StopRequested.Set(1);
+	WorkEvent->Trigger();
+}
+
+bool FRenderDocPluginCaptureMover::MoveCapture(const FString& Source, const FString& Destination, const FString& Label) const
+{
+	const double StartTime = FPlatformTime::Seconds();
+	IFileManager& FileManager = IFileManager::Get();
+
+	// Copy while hashing the source, then hash the copy as read back from the
+	// destination; only a verified copy allows the scratch file to be deleted:
+	uint8 SourceDigest [16];
+	uint8 DestinationDigest [16];
+	int64 Size (0);
+	{
+		TUniquePtr<FArchive> Reader (FileManager.CreateFileReader(*Source));
+		TUniquePtr<FArchive> Writer (FileManager.CreateFileWriter(*Destination));
+		if (!Reader || !Writer)
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("capture mover: unable to copy '%s' to '%s'"), *Source, *Destination);
+			return(false);
+		}
+
+		TArray<uint8> Block;
+		Block.SetNumUninitialized(CopyBlockSize);
+
+		FMD5 MD5;
+		Size = Reader->TotalSize();
+		int64 Remaining = Size;
+		int64 NextProgress = ProgressInterval;
+		while (Remaining > 0)
+		{
+			const int32 BlockSize = (int32)FMath::Min<int64>(Remaining, CopyBlockSize);
+			Reader->Serialize(Block.GetData(), BlockSize);
+			Writer->Serialize(Block.GetData(), BlockSize);
+			MD5.Update(Block.GetData(), BlockSize);
+			Remaining -= BlockSize;
+
+			if (Events && (Size - Remaining) >= NextProgress)
+			{
+				FRenderDocPluginEvent Progress (ERenderDocCaptureStage::Migrating, Source, Size - Remaining, Size);
+				Progress.Label = Label;
+				Events->Post(Progress);
+				NextProgress += ProgressInterval;
+			}
+		}
+		MD5.Final(SourceDigest);
+
+		if (!Writer->Close() || Reader->IsError())
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("capture mover: I/O error while copying '%s' to '%s'"), *Source, *Destination);
+			FileManager.Delete(*Destination);
+			return(false);
+		}
+	}
+
+	if ((FileManager.FileSize(*Destination) != Size) || !HashFile(Destination, DestinationDigest) ||
+		(FMemory::Memcmp(SourceDigest, DestinationDigest, sizeof(SourceDigest)) != 0))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("capture mover: verification of '%s' failed; the capture has been kept at '%s'"), *Destination, *Source);
+		FileManager.Delete(*Destination);
+		return(false);
+	}
+
+	FileManager.Delete(*Source);
+	UE_LOG(RenderDocPlugin, Log, TEXT("capture mover: '%s' migrated (%lld bytes, %.2f s)"), *Destination, Size, FPlatformTime::Seconds() - StartTime);
+	return(true);
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#include "RenderDocPluginEvents.h"
+
+/**
+* Migrates finished captures from a fast scratch directory (local NVMe, RAM disk)
+* to their final location on a low-priority background thread. RenderDoc writes
+* the capture to scratch during EndFrameCapture, which keeps that stall short
+* even when the project drive is slow or network-backed; the mover then copies
+* the capture, verifies the copy (size and MD5) and frees the scratch space.
+*/
+class FRenderDocPluginCaptureMover : public FRunnable
+{
+public:
+	FRenderDocPluginCaptureMover(const FString& InScratchDirectory, const FString& InDestinationDirectory, FRenderDocPluginEventChannel* InEvents);
+	virtual ~FRenderDocPluginCaptureMover();
+
+	/**
+	* Queues a capture for migration. OnMoved is called from the mover thread with
+	* the final path of the capture (or an empty string if migration failed, in
+	* which case the capture is left untouched in the scratch directory). Label is
+	* reported with the progress events.
+	*/
+	void Enqueue(const FString& CaptureFile, const FString& Label, TFunction<void(const FString&)> OnMoved);
+
+	/**
+	* Queues the captures left behind in the scratch directory by a previous session.
+	* The scratch directory may be shared with other running sessions, so only the
+	* captures nobody has written to for a while are picked up.
+	*/
+	void EnqueueLeftovers(TFunction<void(const FString&)> OnMoved);
+
+	// FRunnable interface:
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	bool MoveCapture(const FString& Source, const FString& Destination, const FString& Label) const;
+
+	struct FJob
+	{
+		FString CaptureFile;
+		FString Label;
+		TFunction<void(const FString&)> OnMoved;
+	};
+
+	FString ScratchDirectory;
+	FString DestinationDirectory;
+	FRenderDocPluginEventChannel* Events;
+
+	TQueue<FJob, EQueueMode::Mpsc> Jobs;
+	FEvent* WorkEvent;
+	FThreadSafeCounter StopRequested;
+	FRunnableThread* Thread;
+};
@@ -0,0 +1,249 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+/**
+* Capture scheduling core: decides, at every engine frame boundary, when frame,
+* range and startup captures begin and end. It knows nothing about the engine:
+* time, frame numbers and RenderDoc itself are reached through the three
+* interfaces below, and it only relies on the integer typedefs of the engine
+* (uint32, uint64), so that it can be built and exercised on its own (see
+* Extras/CaptureSchedulerBench).
+*
+* Not thread-safe: every call is expected on the same thread (the game thread).
+*/
+
+class IRenderDocCaptureClock
+{
+public:
+	virtual ~IRenderDocCaptureClock() { }
+	virtual double GetSeconds() const = 0;
+};
+
+class IRenderDocFrameSource
+{
+public:
+	virtual ~IRenderDocFrameSource() { }
+
+	/** Engine ticks (GFrameCounter); a frame capture spans exactly one of them. */
+	virtual uint64 GetEngineFrame() const = 0;
+
+	/** Rendered frames (GFrameNumber), on which startup captures are armed. */
+	virtual uint64 GetRenderFrame() const = 0;
+};
+
+struct FRenderDocCaptureRequest
+{
+	enum EKind
+	{
+		Frame,          // a single engine tick, on request
+		Range,          // every engine tick until EndRange(), or MaxFrames of them
+		StartupFrame,   // the engine tick rendering TargetRenderFrame
+		FirstFrames,    // the first MaxFrames engine ticks after boot (or a map load)
+	};
+
+	EKind Kind;
+	uint64 RequestedFrame;     // engine frame of the request
+	uint64 StartFrame;         // engine frame the capture began at
+	uint64 TargetRenderFrame;  // StartupFrame: the render frame asked for...
+	uint64 RenderFrame;        // ...and the one captured (later, if the former went by)
+	uint32 MaxFrames;          // Range, FirstFrames: frame cap (0: none)
+	double StartSeconds;
+
+	explicit FRenderDocCaptureRequest(EKind InKind = Frame)
+		: Kind(InKind), RequestedFrame(0), StartFrame(0), TargetRenderFrame(0), RenderFrame(0), MaxFrames(0), StartSeconds(0.0)
+	{ }
+};
+
+class IRenderDocCaptureBackend
+{
+public:
+	virtual ~IRenderDocCaptureBackend() { }
+
+	/** Last word on a capture before it gets armed or begins (memory budget...); false drops it. */
+	virtual bool AdmitScheduledCapture(const FRenderDocCaptureRequest& Request) = 0;
+
+	virtual void BeginScheduledCapture(const FRenderDocCaptureRequest& Request) = 0;
+
+	/**
+	* @param Frames Engine frames spanned by the capture.
+	* @param Seconds Time between its beginning and its end.
+	*/
+	virtual void EndScheduledCapture(const FRenderDocCaptureRequest& Request, uint64 Frames, double Seconds) = 0;
+};
+
+class FRenderDocPluginCaptureScheduler
+{
+public:
+	FRenderDocPluginCaptureScheduler(IRenderDocCaptureClock& InClock, IRenderDocFrameSource& InFrames, IRenderDocCaptureBackend& InBackend)
+		: Clock(InClock), Frames(InFrames), Backend(InBackend)
+		, State(Idle), StartupRenderFrame(0), StartupFrames(0)
+	{ }
+
+	bool IsIdle() const { return(State == Idle); }
+	bool IsRangeActive() const { return(State == CapturingRange); }
+
+	/** Engine frames recorded so far by the active range capture. */
+	uint64 GetRangeFrames() const { return(IsRangeActive() ? Frames.GetEngineFrame() - Current.StartFrame : 0); }
+
+	/** Frame cap of the active range capture (0 if uncapped, or no range capture is active). */
+	uint64 GetRangeMaxFrames() const { return(IsRangeActive() ? Current.MaxFrames : 0); }
+
+	/**
+	* Arms the capture of the next engine tick, from its beginning (OnBeginFrame) to
+	* its end (OnEndFrame).
+	* @return False if another capture is armed or in progress, or it was not admitted.
+	*/
+	bool RequestFrame()
+	{
+		if (State != Idle)
+			return(false);
+
+		FRenderDocCaptureRequest Request (FRenderDocCaptureRequest::Frame);
+		Request.RequestedFrame = Frames.GetEngineFrame();
+		return(Arm(Request));
+	}
+
+	/**
+	* Arms a range capture, which begins at the next engine tick, like frame
+	* captures, and lasts until EndRange() or MaxFrames engine ticks (0: no cap).
+	*/
+	bool BeginRange(uint32 MaxFrames)
+	{
+		if (State != Idle)
+			return(false);
+
+		FRenderDocCaptureRequest Request (FRenderDocCaptureRequest::Range);
+		Request.RequestedFrame = Frames.GetEngineFrame();
+		Request.MaxFrames = MaxFrames;
+		return(Arm(Request));
+	}
+
+	/** Ends the range capture in progress, or disarms one that has not begun yet. */
+	bool EndRange()
+	{
+		if (State == Armed && Current.Kind == FRenderDocCaptureRequest::Range)
+		{
+			State = Idle;
+			return(true);
+		}
+		if (State != CapturingRange)
+			return(false);
+
+		End(Frames.GetEngineFrame() - Current.StartFrame);
+		return(true);
+	}
+
+	/** Captures the engine tick that renders the given frame (0 disarms). */
+	void ArmStartupFrame(uint64 RenderFrame) { StartupRenderFrame = RenderFrame; }
+
+	/** Captures the next Count engine ticks, as a range, as soon as nothing else is being captured. */
+	void ArmFirstFrames(uint32 Count) { StartupFrames = Count; }
+
+	/**
+	* To be called at the beginning of every engine tick, before any rendering
+	* command of that tick gets enqueued.
+	* @param bOtherCaptureActive A capture the scheduler does not own (viewport,
+	* scoped...) is pending; startup captures wait for it.
+	*/
+	void OnBeginFrame(bool bOtherCaptureActive = false)
+	{
+		if (State == CapturingRange && Current.MaxFrames != 0 && GetRangeFrames() >= Current.MaxFrames)
+			EndRange();
+
+		if (State == Idle && !bOtherCaptureActive)
+		{
+			const uint64 RenderFrame = Frames.GetRenderFrame();
+			if (StartupRenderFrame != 0 && RenderFrame >= StartupRenderFrame)
+			{
+				FRenderDocCaptureRequest Request (FRenderDocCaptureRequest::StartupFrame);
+				Request.RequestedFrame = Frames.GetEngineFrame();
+				Request.TargetRenderFrame = StartupRenderFrame;
+				Request.RenderFrame = RenderFrame;
+				StartupRenderFrame = 0;
+				Arm(Request);
+			}
+			else if (StartupFrames != 0)
+			{
+				FRenderDocCaptureRequest Request (FRenderDocCaptureRequest::FirstFrames);
+				Request.RequestedFrame = Frames.GetEngineFrame();
+				Request.MaxFrames = StartupFrames;
+				StartupFrames = 0;
+				Arm(Request);
+			}
+		}
+
+		if (State == Armed)
+		{
+			const bool bRange = (Current.Kind == FRenderDocCaptureRequest::Range) || (Current.Kind == FRenderDocCaptureRequest::FirstFrames);
+			Begin();
+			State = bRange ? CapturingRange : CapturingFrame;
+		}
+	}
+
+	/** To be called at the end of every engine tick, after its last rendering command. */
+	void OnEndFrame()
+	{
+		if (State == CapturingFrame)
+			End(1);
+	}
+
+private:
+	bool Arm(const FRenderDocCaptureRequest& Request)
+	{
+		if (!Backend.AdmitScheduledCapture(Request))
+			return(false);
+
+		Current = Request;
+		State = Armed;
+		return(true);
+	}
+
+	void Begin()
+	{
+		Current.StartFrame = Frames.GetEngineFrame();
+		Current.StartSeconds = Clock.GetSeconds();
+		Backend.BeginScheduledCapture(Current);
+	}
+
+	void End(uint64 CapturedFrames)
+	{
+		// Idle before calling out, so that the backend may request the next capture:
+		State = Idle;
+		Backend.EndScheduledCapture(Current, CapturedFrames, Clock.GetSeconds() - Current.StartSeconds);
+	}
+
+	enum EState { Idle, Armed, CapturingFrame, CapturingRange };
+
+	IRenderDocCaptureClock& Clock;
+	IRenderDocFrameSource& Frames;
+	IRenderDocCaptureBackend& Backend;
+
+	EState State;
+	FRenderDocCaptureRequest Current;
+	uint64 StartupRenderFrame;
+	uint32 StartupFrames;
+};
@@ -0,0 +1,360 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginCaptureStore.h"
+
+#include "RenderDocPluginModule.h"
+
+#include "SecureHash.h"
+
+// Chunk size limits; the average chunk size is governed by the number of bits
+// tested in the rolling hash (16 bits -> 64KB on average):
+static const int32  MinChunkSize  = 16 * 1024;
+static const int32  MaxChunkSize  = 256 * 1024;
+static const uint64 ChunkHashMask = 0xFFFF000000000000ull;
+
+static const int32  ReadBlockSize = 1024 * 1024;
+
+static const TCHAR* ManifestMagic = TEXT("RDCM 1");
+
+// Concurrent ingests (or rebuilds) may write the same file at the same time; each
+// one writes under its own temporary name, and moves it into place when complete:
+static FString GetTempPath(const FString& Path)
+{
+	return(Path + TEXT(".") + FGuid::NewGuid().ToString() + TEXT(".tmp"));
+}
+
+/**
+* Gear table for the rolling hash: 256 pseudo-random 64-bit values, generated
+* deterministically (splitmix64) so that every machine cuts files identically.
+*/
+static const uint64* GetGearTable()
+{
+	static uint64 Gear [256];
+	static bool bInitialized (false);
+	if (!bInitialized)
+	{
+		uint64 State = 0x52656E646572446Full;  // "RenderDo"
+		for (int32 i = 0; i < 256; ++i)
+		{
+			uint64 Z = (State += 0x9E3779B97F4A7C15ull);
+			Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+			Gear[i] = Z ^ (Z >> 31);
+		}
+		bInitialized = true;
+	}
+	return(Gear);
+}
+
+static FString HashChunk(const uint8* Data, int32 Size)
+{
+	uint8 Digest [20];
+	FSHA1::HashBuffer(Data, Size, Digest);
+	return(BytesToHex(Digest, sizeof(Digest)));
+}
+
+FRenderDocPluginCaptureStore::FRenderDocPluginCaptureStore()
+{
+	FString Directory;
+	if (!GConfig || !GConfig->GetString(TEXT("RenderDoc"), TEXT("CaptureStorePath"), Directory, GGameIni) || Directory.IsEmpty())
+		Directory = FPaths::Combine(*FPaths::GameSavedDir(), TEXT("RenderDocCaptures"), TEXT("Store"));
+	StoreDirectory = FPaths::ConvertRelativePathToFull(Directory);
+	FPaths::NormalizeDirectoryName(StoreDirectory);
+	GetGearTable();
+
+	int32 CacheMB (4096);
+	if (GConfig)
+		GConfig->GetInt(TEXT("RenderDoc"), TEXT("CaptureStoreCacheMB"), CacheMB, GGameIni);
+	MaxCacheBytes = (int64)FMath::Max(0, CacheMB) * 1024 * 1024;
+}
+
+FString FRenderDocPluginCaptureStore::GetChunkPath(const FString& ChunkHash) const
+{
+	return(FPaths::Combine(*StoreDirectory, TEXT("chunks"), *ChunkHash.Left(2), *(ChunkHash + TEXT(".chunk"))));
+}
+
+FString FRenderDocPluginCaptureStore::GetManifestPath(const FString& CaptureName) const
+{
+	return(FPaths::Combine(*StoreDirectory, TEXT("manifests"), *(CaptureName + TEXT(".rdcm"))));
+}
+
+bool FRenderDocPluginCaptureStore::IsIngested(const FString& CaptureFile) const
+{
+	FString Manifest;
+	if (!FFileHelper::LoadFileToString(Manifest, *GetManifestPath(FPaths::GetBaseFilename(CaptureFile))))
+		return(false);
+
+	TArray<FString> Lines;
+	Manifest.ParseIntoArrayLines(Lines);
+	if (Lines.Num() < 2 || Lines[0] != ManifestMagic)
+		return(false);
+
+	const int64 TotalSize = FCString::Atoi64(*Lines[1]);
+	if (IFileManager::Get().FileSize(*CaptureFile) != TotalSize)
+		return(false);
+
+	int64 ChunksSize (0);
+	for (int32 i = 2; i < Lines.Num(); ++i)
+	{
+		FString ChunkHash, ChunkSize;
+		if (!Lines[i].Split(TEXT(" "), &ChunkHash, &ChunkSize))
+			return(false);
+
+		const int64 Size = FCString::Atoi64(*ChunkSize);
+		if (IFileManager::Get().FileSize(*GetChunkPath(ChunkHash)) != Size)
+			return(false);
+		ChunksSize += Size;
+	}
+	return(ChunksSize == TotalSize);
+}
+
+bool FRenderDocPluginCaptureStore::Ingest(const FString& CaptureFile) const
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	TUniquePtr<FArchive> Reader (FileManager.CreateFileReader(*CaptureFile));
+	if (!Reader)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("capture store: unable to open '%s' for ingestion"), *CaptureFile);
+		return(false);
+	}
+
+	const int64 TotalSize = Reader->TotalSize();
+	const uint64* Gear = GetGearTable();
+
+	FString Manifest = FString::Printf(TEXT("%s\n%lld\n"), ManifestMagic, TotalSize);
+	int64 NewBytes (0);
+	int32 NumChunks (0);
+	int32 NumNewChunks (0);
+
+	TArray<uint8> Block;
+	Block.SetNumUninitialized(ReadBlockSize);
+	TArray<uint8> Chunk;
+	Chunk.Reserve(MaxChunkSize);
+
+	auto FlushChunk = [&]() -> bool
+	{
+		const FString ChunkHash = HashChunk(Chunk.GetData(), Chunk.Num());
+		const FString ChunkPath = GetChunkPath(ChunkHash);
+		Manifest += FString::Printf(TEXT("%s %d\n"), *ChunkHash, Chunk.Num());
+		++NumChunks;
+
+		if (!FPaths::FileExists(ChunkPath))
+		{
+			// Write under a temporary name first so that a half-written chunk is
+			// never mistaken for a valid one:
+			const FString TempPath = GetTempPath(ChunkPath);
+			TUniquePtr<FArchive> Writer (FileManager.CreateFileWriter(*TempPath));
+			if (!Writer)
+				return(false);
+			Writer->Serialize(Chunk.GetData(), Chunk.Num());
+			const bool bWritten = Writer->Close() && !Writer->IsError();
+			Writer.Reset();
+			if (!bWritten || !FileManager.Move(*ChunkPath, *TempPath, true, true))
+			{
+				FileManager.Delete(*TempPath);
+				return(false);
+			}
+			NewBytes += Chunk.Num();
+			++NumNewChunks;
+		}
+
+		Chunk.Reset();
+		return(true);
+	};
+
+	uint64 Hash (0);
+	int64 Remaining = TotalSize;
+	while (Remaining > 0)
+	{
+		const int32 BlockSize = (int32)FMath::Min<int64>(Remaining, ReadBlockSize);
+		Reader->Serialize(Block.GetData(), BlockSize);
+		Remaining -= BlockSize;
+		if (Reader->IsError())
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("capture store: unable to read '%s'"), *CaptureFile);
+			return(false);
+		}
+
+		int32 Start (0);
+		for (int32 i = 0; i < BlockSize; ++i)
+		{
+			Hash = (Hash << 1) + Gear[Block[i]];
+
+			const int32 Size = Chunk.Num() + (i - Start + 1);
+			if ((Size >= MinChunkSize && (Hash & ChunkHashMask) == 0) || Size >= MaxChunkSize)
+			{
+				Chunk.Append(Block.GetData() + Start, i - Start + 1);
+				Start = i + 1;
+				if (!FlushChunk())
+				{
+					UE_LOG(RenderDocPlugin, Warning, TEXT("capture store: unable to write chunk for '%s'"), *CaptureFile);
+					return(false);
+				}
+				Hash = 0;
+			}
+		}
+		Chunk.Append(Block.GetData() + Start, BlockSize - Start);
+	}
+
+	if (Chunk.Num() > 0 && !FlushChunk())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("capture store: unable to write chunk for '%s'"), *CaptureFile);
+		return(false);
+	}
+
+	// The raw capture is deleted once it has a manifest (see PruneIngestedCaptures),
+	// so a truncated manifest must never take the place of a complete one:
+	const FString CaptureName = FPaths::GetBaseFilename(CaptureFile);
+	const FString ManifestPath = GetManifestPath(CaptureName);
+	const FString TempManifestPath = GetTempPath(ManifestPath);
+	if (!FFileHelper::SaveStringToFile(Manifest, *TempManifestPath) || !FileManager.Move(*ManifestPath, *TempManifestPath, true, true))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("capture store: unable to write manifest for '%s'"), *CaptureFile);
+		FileManager.Delete(*TempManifestPath);
+		return(false);
+	}
+
+	UE_LOG(RenderDocPlugin, Log, TEXT("capture store: '%s' ingested (%d chunks, %d new; %lld of %lld bytes stored)"),
+		*CaptureName, NumChunks, NumNewChunks, NewBytes, TotalSize);
+	return(true);
+}
+
+FString FRenderDocPluginCaptureStore::Rebuild(const FString& CaptureName) const
+{
+	const FString OutputFile = FPaths::Combine(*StoreDirectory, TEXT("cache"), *(CaptureName + TEXT(".log")));
+
+	FString Manifest;
+	if (!FFileHelper::LoadFileToString(Manifest, *GetManifestPath(CaptureName)))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("capture store: no manifest for capture '%s'"), *CaptureName);
+		return(FString());
+	}
+
+	TArray<FString> Lines;
+	Manifest.ParseIntoArrayLines(Lines);
+	if (Lines.Num() < 2 || Lines[0] != ManifestMagic)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("capture store: manifest of '%s' is malformed"), *CaptureName);
+		return(FString());
+	}
+
+	const int64 TotalSize = FCString::Atoi64(*Lines[1]);
+	if (IFileManager::Get().FileSize(*OutputFile) == TotalSize)
+	{
+		// Keeps it out of the next cache pruning:
+		IFileManager::Get().SetTimeStamp(*OutputFile, FDateTime::UtcNow());
+		return(OutputFile);
+	}
+
+	const FString TempFile = GetTempPath(OutputFile);
+	TUniquePtr<FArchive> Writer (IFileManager::Get().CreateFileWriter(*TempFile));
+	if (!Writer)
+		return(FString());
+
+	int64 Written (0);
+	TArray<uint8> Chunk;
+	for (int32 i = 2; i < Lines.Num(); ++i)
+	{
+		FString ChunkHash, ChunkSize;
+		if (!Lines[i].Split(TEXT(" "), &ChunkHash, &ChunkSize))
+			continue;
+
+		// Re-hash every chunk on the way out; a corrupted store must not silently
+		// produce a corrupted capture:
+		if (!FFileHelper::LoadFileToArray(Chunk, *GetChunkPath(ChunkHash)) ||
+			Chunk.Num() != FCString::Atoi(*ChunkSize) ||
+			HashChunk(Chunk.GetData(), Chunk.Num()) != ChunkHash)
+		{
+			UE_LOG(RenderDocPlugin, Error, TEXT("capture store: chunk %s of '%s' is missing or corrupted"), *ChunkHash, *CaptureName);
+			Writer->Close();
+			IFileManager::Get().Delete(*TempFile);
+			return(FString());
+		}
+
+		Writer->Serialize(Chunk.GetData(), Chunk.Num());
+		Written += Chunk.Num();
+	}
+	const bool bWritten = Writer->Close() && !Writer->IsError();
+	Writer.Reset();
+
+	if (!bWritten || Written != TotalSize || !IFileManager::Get().Move(*OutputFile, *TempFile, true, true))
+	{
+		UE_LOG(RenderDocPlugin, Error, TEXT("capture store: unable to rebuild '%s'"), *CaptureName);
+		IFileManager::Get().Delete(*TempFile);
+		return(FString());
+	}
+
+	PruneCache();
+	return(OutputFile);
+}
+
+void FRenderDocPluginCaptureStore::PruneCache() const
+{
+	struct FCachedCapture
+	{
+		FString Path;
+		FDateTime Timestamp;
+		int64 Size;
+	};
+
+	const FString CacheDirectory = FPaths::Combine(*StoreDirectory, TEXT("cache"));
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *FPaths::Combine(*CacheDirectory, TEXT("*.log")), true, false);
+
+	TArray<FCachedCapture> Captures;
+	int64 TotalSize (0);
+	for (const FString& File : Files)
+	{
+		FCachedCapture Capture;
+		Capture.Path = FPaths::Combine(*CacheDirectory, *File);
+		Capture.Timestamp = IFileManager::Get().GetTimeStamp(*Capture.Path);
+		Capture.Size = FMath::Max<int64>(0, IFileManager::Get().FileSize(*Capture.Path));
+		TotalSize += Capture.Size;
+		Captures.Add(Capture);
+	}
+
+	// Least recently used first; the capture just rebuilt is the most recent one:
+	Captures.Sort([](const FCachedCapture& A, const FCachedCapture& B) { return(A.Timestamp < B.Timestamp); });
+	for (int32 i = 0; i < Captures.Num() - 1 && TotalSize > MaxCacheBytes; ++i)
+	{
+		if (IFileManager::Get().Delete(*Captures[i].Path))
+			TotalSize -= Captures[i].Size;
+	}
+}
+
+void FRenderDocPluginCaptureStore::PruneIngestedCaptures(const FString& CaptureDirectory) const
+{
+	TArray<FString> Captures;
+	IFileManager::Get().FindFiles(Captures, *FPaths::Combine(*CaptureDirectory, TEXT("*.log")), true, false);
+	for (const FString& Capture : Captures)
+	{
+		const FString CaptureFile = FPaths::Combine(*CaptureDirectory, *Capture);
+		if (IsIngested(CaptureFile))
+			IFileManager::Get().Delete(*CaptureFile);
+	}
+}
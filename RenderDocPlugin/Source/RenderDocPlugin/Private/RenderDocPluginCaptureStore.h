@@ -0,0 +1,85 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+/**
+* Content-addressed storage for finished frame captures.
+*
+* Captures of the same map share most of their texture and buffer payloads, so
+* every capture file is cut into content-defined chunks (the cut points follow
+* a rolling "gear" hash over the file bytes, so an insertion early in the file
+* does not shift every chunk after it). Each chunk is stored once, under its
+* SHA1, and every capture is reduced to a small manifest listing its chunks:
+*
+*   <Store>/chunks/<2 hex digits>/<40 hex digits>.chunk
+*   <Store>/manifests/<capture name>.rdcm
+*
+* Captures are rebuilt from their manifest on demand, right before opening.
+*/
+class FRenderDocPluginCaptureStore
+{
+public:
+	FRenderDocPluginCaptureStore();
+
+	/** Root directory of the store (Saved/RenderDocCaptures/Store by default). */
+	const FString& GetStoreDirectory() const { return(StoreDirectory); }
+
+	/**
+	* Splits a capture file into chunks and writes its manifest. Safe to call from
+	* any thread; blocking (reads the whole capture), so keep it off the game thread.
+	* @return True if the manifest has been written.
+	*/
+	bool Ingest(const FString& CaptureFile) const;
+
+	/**
+	* Rebuilds a capture from its manifest into the store cache directory (or just
+	* returns the path if it has already been rebuilt).
+	* @return The full path of the rebuilt capture, or an empty string on failure.
+	*/
+	FString Rebuild(const FString& CaptureName) const;
+
+	/**
+	* True if the capture file can be rebuilt from the store: its manifest is well
+	* formed, matches the size of the file, and every chunk it lists is there.
+	*/
+	bool IsIngested(const FString& CaptureFile) const;
+
+	/** Deletes raw captures in CaptureDirectory that have been ingested (see IsIngested). */
+	void PruneIngestedCaptures(const FString& CaptureDirectory) const;
+
+	/**
+	* Deletes the least recently used rebuilt captures until the cache fits in
+	* CaptureStoreCacheMB (4GB by default); the most recent one is always kept.
+	*/
+	void PruneCache() const;
+
+private:
+	FString GetChunkPath(const FString& ChunkHash) const;
+	FString GetManifestPath(const FString& CaptureName) const;
+
+	FString StoreDirectory;
+	int64 MaxCacheBytes;
+};
@@ -0,0 +1,243 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginCaptureSync.h"
+
+#if RENDERDOC_PLUGIN_SYNC
+
+#include "RenderDocPluginModule.h"
+
+#include "Networking.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+static const TCHAR* MessageMagic = TEXT("RDSYNC1");
+
+// Requests are a single datagram, sent a few times over since UDP may drop one;
+// receivers ignore the duplicates:
+static const int32 MessageRepeats = 3;
+
+// Lateness (seconds) past which a synchronized capture is reported as such:
+static const double LateWarningSeconds = 0.25;
+
+FRenderDocPluginCaptureSync::FRenderDocPluginCaptureSync()
+	: Socket(NULL)
+	, NextSequence(1)
+	, bArmed(false)
+	, TargetUtc(0.0)
+	, TargetServerSeconds(-1.0)
+	, GroupIP(TEXT("230.0.0.1"))
+	, Port(6680)
+	, LeadSeconds(1.0f)
+	, FallbackCommand(TEXT("stat dumpframe -ms=0.1"))
+{
+	ProcessId = FString::Printf(TEXT("%08x"), FGuid::NewGuid().A);
+
+	if (!GConfig)
+		return;
+
+	GConfig->GetString(TEXT("RenderDoc"), TEXT("CaptureSyncGroup"),       GroupIP,         GGameIni);
+	GConfig->GetInt   (TEXT("RenderDoc"), TEXT("CaptureSyncPort"),        Port,            GGameIni);
+	GConfig->GetFloat (TEXT("RenderDoc"), TEXT("CaptureSyncLeadSeconds"), LeadSeconds,     GGameIni);
+	GConfig->GetString(TEXT("RenderDoc"), TEXT("CaptureSyncCommand"),     FallbackCommand, GGameIni);
+}
+
+FRenderDocPluginCaptureSync::~FRenderDocPluginCaptureSync()
+{
+	Leave();
+}
+
+bool FRenderDocPluginCaptureSync::Join()
+{
+	if (IsJoined())
+		return(true);
+
+	FIPv4Address Group;
+	if (!FIPv4Address::Parse(GroupIP, Group))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("synchronized capture: invalid multicast group '%s'"), *GroupIP);
+		return(false);
+	}
+
+	// Reusable, with multicast loopback: every process of the machine binds the
+	// same port and receives every request, its own ones included:
+	Socket = FUdpSocketBuilder(TEXT("RenderDocCaptureSync"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToPort(Port)
+		.JoinedToGroup(Group)
+		.WithMulticastLoopback()
+		.WithMulticastTtl(1);
+	if (!Socket)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("synchronized capture: unable to join %s:%d"), *GroupIP, Port);
+		return(false);
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	GroupAddress = SocketSubsystem->CreateInternetAddr(Group.Value, Port);
+	SenderAddress = SocketSubsystem->CreateInternetAddr();
+	UE_LOG(RenderDocPlugin, Log, TEXT("synchronized capture: joined %s:%d as %s"), *GroupIP, Port, *ProcessId);
+	return(true);
+}
+
+void FRenderDocPluginCaptureSync::Leave()
+{
+	if (!Socket)
+		return;
+
+	Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	Socket = NULL;
+	bArmed = false;
+}
+
+bool FRenderDocPluginCaptureSync::Broadcast(float InLeadSeconds)
+{
+	if (!Join())
+		return(false);
+
+	const float Lead = (InLeadSeconds >= 0.0f) ? InLeadSeconds : LeadSeconds;
+	const TCHAR* Role;
+	const double ServerSeconds = GetServerWorldSeconds(Role);
+	const FString Message = FString::Printf(TEXT("%s %s %u %.6f %.6f"), MessageMagic, *ProcessId, NextSequence++,
+		GetUtcSeconds() + Lead, (ServerSeconds >= 0.0) ? ServerSeconds + Lead : -1.0);
+
+	FTCHARToUTF8 Datagram (*Message);
+	for (int32 i = 0; i < MessageRepeats; ++i)
+	{
+		int32 BytesSent (0);
+		if (!Socket->SendTo((const uint8*)Datagram.Get(), Datagram.Length(), BytesSent, *GroupAddress))
+			UE_LOG(RenderDocPlugin, Warning, TEXT("synchronized capture: unable to send to %s:%d"), *GroupIP, Port);
+	}
+
+	// Do not rely on the loopback for this process' own request:
+	return(Arm(Message));
+}
+
+bool FRenderDocPluginCaptureSync::Tick(FString& CaptureLabel)
+{
+	if (!IsJoined())
+		return(false);
+
+	Receive();
+	if (!bArmed)
+		return(false);
+
+	const TCHAR* Role;
+	const double ServerSeconds = GetServerWorldSeconds(Role);
+	const bool bServerClock = (TargetServerSeconds >= 0.0 && ServerSeconds >= 0.0);
+	const double Lateness = bServerClock ? ServerSeconds - TargetServerSeconds : GetUtcSeconds() - TargetUtc;
+	if (Lateness < 0.0)
+		return(false);
+
+	bArmed = false;
+	if (Lateness > LateWarningSeconds)
+		UE_LOG(RenderDocPlugin, Warning, TEXT("synchronized capture %s: %.2f s late"), *ArmedRequest, Lateness);
+
+	// Logged by every process, to relate the captures to each other afterwards:
+	UE_LOG(RenderDocPlugin, Log, TEXT("synchronized capture %s: %s frame %llu, server world time %.3f (%s clock)"),
+		*ArmedRequest, Role, (uint64)GFrameCounter, ServerSeconds, bServerClock ? TEXT("server") : TEXT("UTC"));
+	CaptureLabel = FString::Printf(TEXT("Sync_%s_%s_%u"), *ArmedRequest, Role, FPlatformProcess::GetCurrentProcessId());
+	return(true);
+}
+
+void FRenderDocPluginCaptureSync::Receive()
+{
+	// Read into a fixed buffer; requests are a few dozen bytes:
+	uint8 Buffer [256];
+	int32 BytesRead (0);
+	while (Socket->RecvFrom(Buffer, sizeof(Buffer) - 1, BytesRead, *SenderAddress) && BytesRead > 0)
+	{
+		Buffer[BytesRead] = 0;
+		Arm(UTF8_TO_TCHAR((const ANSICHAR*)Buffer));
+	}
+}
+
+bool FRenderDocPluginCaptureSync::Arm(const FString& Message)
+{
+	TArray<FString> Tokens;
+	Message.ParseIntoArrayWS(Tokens);
+	if (Tokens.Num() != 5 || Tokens[0] != MessageMagic)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("synchronized capture: ignoring malformed request '%s'"), *Message);
+		return(false);
+	}
+
+	const FString Request = Tokens[1] + TEXT("-") + Tokens[2];
+	if (Request == LastRequest)
+		return(false);
+	LastRequest = Request;
+
+	if (bArmed)
+		UE_LOG(RenderDocPlugin, Warning, TEXT("synchronized capture %s: superseded by %s"), *ArmedRequest, *Request);
+
+	bArmed = true;
+	ArmedRequest = Request;
+	TargetUtc = FCString::Atod(*Tokens[3]);
+	TargetServerSeconds = FCString::Atod(*Tokens[4]);
+	UE_LOG(RenderDocPlugin, Log, TEXT("synchronized capture %s: armed, due in %.2f s"), *Request, TargetUtc - GetUtcSeconds());
+	return(true);
+}
+
+double FRenderDocPluginCaptureSync::GetUtcSeconds()
+{
+	return((FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalSeconds());
+}
+
+double FRenderDocPluginCaptureSync::GetServerWorldSeconds(const TCHAR*& OutRole)
+{
+	OutRole = TEXT("Standalone");
+	if (!GEngine)
+		return(-1.0);
+
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		UWorld* World = Context.World();
+		if (!World || (Context.WorldType != EWorldType::Game && Context.WorldType != EWorldType::PIE))
+			continue;
+
+		// Standalone worlds have a game state too, but their clocks are unrelated:
+		switch (World->GetNetMode())
+		{
+		case NM_DedicatedServer :
+		case NM_ListenServer :    OutRole = TEXT("Server"); break;
+		case NM_Client :          OutRole = TEXT("Client"); break;
+		default :                 return(-1.0);
+		}
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 14
+		const AGameStateBase* GameState = World->GetGameState();
+#else
+		const AGameState* GameState = World->GameState;
+#endif
+		return(GameState ? GameState->GetServerWorldTimeSeconds() : -1.0);
+	}
+	return(-1.0);
+}
+
+#endif//RENDERDOC_PLUGIN_SYNC
@@ -0,0 +1,114 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+// Synchronized captures; RenderDocPlugin.Build.cs leaves them out (along with the
+// Sockets and Networking dependencies) of Shipping builds:
+#ifndef RENDERDOC_PLUGIN_SYNC
+#define RENDERDOC_PLUGIN_SYNC !UE_BUILD_SHIPPING
+#endif
+
+#if RENDERDOC_PLUGIN_SYNC
+
+class FSocket;
+class FInternetAddr;
+
+/**
+* Synchronized capture of the same frame by several processes, e.g. a dedicated
+* server and its clients. The processes started with -RenderDocSync join a UDP
+* multicast group (loopback included, so that any number of them can run on the
+* same machine); any of them, or an external tool, then broadcasts a request to
+* capture the frame at a given time, a little in the future:
+*
+*   RDSYNC1 <sender> <sequence> <UTC seconds> <server world seconds, or -1>
+*
+* Every member arms itself for the first frame at or past that time: by the
+* replicated server world time when both the sender and the member have a game
+* state (so that clients capture the frame that simulates the same moment as the
+* server), or else by the UTC wall clock. Processes that cannot capture (a
+* dedicated server, with no RenderDoc) run a console command at that frame
+* instead, "stat dumpframe" by default.
+*
+*   [RenderDoc]
+*   CaptureSyncGroup=230.0.0.1
+*   CaptureSyncPort=6680
+*   CaptureSyncLeadSeconds=1.0      ; how far ahead requests are scheduled
+*   CaptureSyncCommand=stat dumpframe -ms=0.1
+*/
+class FRenderDocPluginCaptureSync
+{
+public:
+	FRenderDocPluginCaptureSync();
+	~FRenderDocPluginCaptureSync();
+
+	/** Joins the multicast group. @return False if the socket could not be set up. */
+	bool Join();
+	void Leave();
+
+	bool IsJoined() const { return(Socket != NULL); }
+
+	/**
+	* Asks every member of the group, this process included, to capture the frame
+	* LeadSeconds from now (the configured lead time if negative).
+	*/
+	bool Broadcast(float LeadSeconds = -1.0f);
+
+	/**
+	* To be called once per engine tick, on the game thread. Returns true when the
+	* synchronized frame has been reached, along with the label of its capture.
+	*/
+	bool Tick(FString& CaptureLabel);
+
+	/** Command run for synchronized frames by processes that cannot capture. */
+	const FString& GetFallbackCommand() const { return(FallbackCommand); }
+
+private:
+	void Receive();
+	bool Arm(const FString& Message);
+	static double GetUtcSeconds();
+	static double GetServerWorldSeconds(const TCHAR*& OutRole);
+
+	FSocket* Socket;
+	TSharedPtr<FInternetAddr> GroupAddress;
+	TSharedPtr<FInternetAddr> SenderAddress;
+	FString ProcessId;
+	uint32 NextSequence;
+
+	// The request armed for, and when it is due:
+	bool bArmed;
+	FString ArmedRequest;
+	FString LastRequest;
+	double TargetUtc;
+	double TargetServerSeconds;
+
+	// Tunables, from the [RenderDoc] section of the game config:
+	FString GroupIP;
+	int32 Port;
+	float LeadSeconds;
+	FString FallbackCommand;
+};
+
+#endif//RENDERDOC_PLUGIN_SYNC
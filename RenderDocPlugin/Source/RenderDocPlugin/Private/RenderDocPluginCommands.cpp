@@ -47,6 +47,14 @@ void FRenderDocPluginCommands::RegisterCommands()
     FInputGesture()
   );
 
+  UI_COMMAND(
+    Settings_DeferredViewportCapture,
+    "Capture Next Natural Frame",
+    "If enabled, viewport captures bracket the next regular draw of the viewport instead of forcing an extra synchronous redraw, keeping frame pacing intact.",
+    EUserInterfaceActionType::ToggleButton,
+    FInputGesture()
+  );
+
   UI_COMMAND(
     Settings_CaptureCallstack,
     "Capture Callstack",
@@ -70,6 +78,14 @@ void FRenderDocPluginCommands::RegisterCommands()
     EUserInterfaceActionType::ToggleButton,
     FInputGesture()
   );
+
+  UI_COMMAND(
+    Settings_UseCaptureStore,
+    "Deduplicate Captures",
+    "Archive finished captures into a chunk-deduplicated store; archived captures are rebuilt on demand via 'RenderDoc.OpenCapture <name>'.",
+    EUserInterfaceActionType::ToggleButton,
+    FInputGesture()
+  );
 }
 PRAGMA_ENABLE_OPTIMIZATION
 
@@ -42,9 +42,11 @@ public:
 
 	TSharedPtr<FUICommandInfo> CaptureFrame;
   TSharedPtr<FUICommandInfo> Settings_CaptureAllActivity;
+  TSharedPtr<FUICommandInfo> Settings_DeferredViewportCapture;
   TSharedPtr<FUICommandInfo> Settings_CaptureCallstack;
   TSharedPtr<FUICommandInfo> Settings_CaptureAllResources;
   TSharedPtr<FUICommandInfo> Settings_SaveAllInitialState;
+  TSharedPtr<FUICommandInfo> Settings_UseCaptureStore;
 };
 
 #endif//WITH_EDITOR
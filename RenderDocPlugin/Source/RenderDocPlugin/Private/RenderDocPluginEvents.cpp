@@ -0,0 +1,59 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginEvents.h"
+
+#include "RenderDocPluginModule.h"
+
+void FRenderDocPluginEventChannel::Post(const FRenderDocPluginEvent& Event)
+{
+	Events.Enqueue(Event);
+
+	// Only the first event posted after a drain schedules the next one:
+	if (DrainScheduled.Set(1) == 0)
+	{
+		// The channel belongs to the module, which may be gone by the time the drain runs:
+		FRenderDocPluginEventChannel* Channel = this;
+		FRenderDocPluginModule::RunAsyncTask(ENamedThreads::GameThread, [Channel]()
+		{
+			if (IRenderDocPlugin::GetIfLoaded())
+				Channel->Drain();
+		});
+	}
+}
+
+void FRenderDocPluginEventChannel::Drain()
+{
+	check(IsInGameThread());
+
+	// Re-arm before dequeuing, so that anything posted from now on (including
+	// from the listeners themselves) schedules another drain:
+	DrainScheduled.Set(0);
+
+	FRenderDocPluginEvent Event;
+	while (Events.Dequeue(Event))
+		CaptureEvent.Broadcast(Event);
+}
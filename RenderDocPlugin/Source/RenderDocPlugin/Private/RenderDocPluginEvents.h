@@ -0,0 +1,82 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+/** Stages a capture goes through, from the request to the GUI being launched. */
+enum class ERenderDocCaptureStage : uint8
+{
+	Requested,   // a capture has been requested (game thread)
+	Capturing,   // StartFrameCapture() has been called (render thread)
+	Writing,     // EndFrameCapture() is writing the capture file (render thread)
+	Migrating,   // the capture is being moved out of the scratch directory
+	Launching,   // the RenderDoc GUI is being launched on the capture
+	Finished,    // the capture is available at its final location
+	Failed,
+	Archiving,   // the capture is being ingested into the capture store
+	Archived,
+};
+
+struct FRenderDocPluginEvent
+{
+	ERenderDocCaptureStage Stage;
+	double Timestamp;      // FPlatformTime::Seconds() when the event was posted
+	int64 BytesWritten;    // progress of the current stage, if known (-1 otherwise)
+	int64 BytesTotal;      // total for the current stage, if known (-1 otherwise)
+	FString CaptureFile;   // once known
+	FString Label;         // label the capture was requested with (see CaptureEntireFrame), if any
+	FString Message;       // reason of a failure, if known
+
+	FRenderDocPluginEvent(ERenderDocCaptureStage InStage, const FString& InCaptureFile = FString(), int64 InBytesWritten = -1, int64 InBytesTotal = -1)
+		: Stage(InStage), Timestamp(FPlatformTime::Seconds()), BytesWritten(InBytesWritten), BytesTotal(InBytesTotal), CaptureFile(InCaptureFile)
+	{ }
+
+	FRenderDocPluginEvent() : FRenderDocPluginEvent(ERenderDocCaptureStage::Failed) { }
+};
+
+/**
+* Lock-free channel carrying capture progress from the render thread and the
+* post-capture workers to the game thread. Posting never blocks; the first
+* event posted into an empty channel schedules a single game thread task that
+* drains it and broadcasts every event to the listeners. Nothing is scheduled,
+* and nothing ticks, while no capture is in flight.
+*/
+class FRenderDocPluginEventChannel
+{
+public:
+	/** May be called from any thread. */
+	void Post(const FRenderDocPluginEvent& Event);
+
+	/** Listeners are always invoked on the game thread, in posting order. */
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnCaptureEvent, const FRenderDocPluginEvent&);
+	FOnCaptureEvent& OnCaptureEvent() { return(CaptureEvent); }
+
+private:
+	void Drain();
+
+	TQueue<FRenderDocPluginEvent, EQueueMode::Mpsc> Events;
+	FThreadSafeCounter DrainScheduled;
+	FOnCaptureEvent CaptureEvent;
+};
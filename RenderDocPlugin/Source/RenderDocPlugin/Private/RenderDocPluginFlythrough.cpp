@@ -0,0 +1,412 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginFlythrough.h"
+
+#include "RenderDocPluginModule.h"
+
+#include "Camera/CameraActor.h"
+#include "Engine/BookMark.h"
+#include "ContentStreaming.h"
+#include "ShaderCompiler.h"
+#include "Json.h"
+
+FRenderDocPluginFlythrough::FRenderDocPluginFlythrough()
+	: State(Idle)
+	, bExitWhenDone(false)
+	, CurrentBookmark(0)
+	, StateFrames(0)
+	, StateStartTime(0.0)
+	, SettleFrames(30)
+	, SettleTimeout(60.0f)
+	, MeasureFrames(60)
+	, WorldTimeout(300.0f)
+	, CaptureTimeout(120.0f)
+{
+	if (!GConfig)
+		return;
+
+	GConfig->GetInt  (TEXT("RenderDoc"), TEXT("FlythroughSettleFrames"),  SettleFrames,  GGameIni);
+	GConfig->GetFloat(TEXT("RenderDoc"), TEXT("FlythroughSettleTimeout"), SettleTimeout, GGameIni);
+	GConfig->GetInt  (TEXT("RenderDoc"), TEXT("FlythroughMeasureFrames"), MeasureFrames, GGameIni);
+	GConfig->GetFloat(TEXT("RenderDoc"), TEXT("FlythroughWorldTimeout"),   WorldTimeout,   GGameIni);
+	GConfig->GetFloat(TEXT("RenderDoc"), TEXT("FlythroughCaptureTimeout"), CaptureTimeout, GGameIni);
+	SettleFrames = FMath::Max(1, SettleFrames);
+	MeasureFrames = FMath::Max(1, MeasureFrames);
+}
+
+void FRenderDocPluginFlythrough::Start(const FString& InBookmarksFile, const FString& InPreset, bool bInExitWhenDone, TFunction<void()> InOnFinished)
+{
+	if (IsRunning())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: already running"));
+		return;
+	}
+
+	BookmarksFile = InBookmarksFile;
+	Preset = InPreset;
+	bExitWhenDone = bInExitWhenDone;
+	OnFinished = InOnFinished;
+	Bookmarks.Empty();
+	Results.Empty();
+	CurrentBookmark = 0;
+	State = WaitingForWorld;
+	StateStartTime = FPlatformTime::Seconds();
+	UE_LOG(RenderDocPlugin, Log, TEXT("flythrough: waiting for a game world (bookmarks: %s)"), BookmarksFile.IsEmpty() ? TEXT("map") : *BookmarksFile);
+}
+
+void FRenderDocPluginFlythrough::Cancel()
+{
+	if (!IsRunning())
+		return;
+
+	UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: cancelled"));
+	bExitWhenDone = false;
+	Finish();
+}
+
+UWorld* FRenderDocPluginFlythrough::FindGameWorld() const
+{
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World())
+			return(Context.World());
+	}
+	return(NULL);
+}
+
+bool FRenderDocPluginFlythrough::LoadBookmarks(UWorld* InWorld)
+{
+	if (!BookmarksFile.IsEmpty())
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadANSITextFileToStrings(*BookmarksFile, NULL, Lines))
+		{
+			UE_LOG(RenderDocPlugin, Error, TEXT("flythrough: unable to read bookmarks file '%s'"), *BookmarksFile);
+			return(false);
+		}
+
+		for (const FString& Line : Lines)
+		{
+			TArray<FString> Tokens;
+			Line.ParseIntoArrayWS(Tokens);
+			if (Tokens.Num() == 0 || Tokens[0].StartsWith(TEXT("#")))
+				continue;
+			if (Tokens.Num() != 7)
+			{
+				UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: ignoring malformed bookmark '%s'"), *Line);
+				continue;
+			}
+
+			FBookmark Bookmark;
+			Bookmark.Name = Tokens[0];
+			Bookmark.Location = FVector(FCString::Atof(*Tokens[1]), FCString::Atof(*Tokens[2]), FCString::Atof(*Tokens[3]));
+			Bookmark.Rotation = FRotator(FCString::Atof(*Tokens[4]), FCString::Atof(*Tokens[5]), FCString::Atof(*Tokens[6]));
+			Bookmarks.Add(Bookmark);
+		}
+	}
+	else if (AWorldSettings* WorldSettings = InWorld->GetWorldSettings())
+	{
+		for (int32 i = 0; i < NUM_BOOKMARKS; ++i)
+		{
+			UBookMark* BookMark = WorldSettings->BookMarks[i];
+			if (!BookMark)
+				continue;
+
+			FBookmark Bookmark;
+			Bookmark.Name = FString::Printf(TEXT("Bookmark%d"), i);
+			Bookmark.Location = BookMark->Location;
+			Bookmark.Rotation = BookMark->Rotation;
+			Bookmarks.Add(Bookmark);
+		}
+	}
+
+	if (Bookmarks.Num() == 0)
+	{
+		UE_LOG(RenderDocPlugin, Error, TEXT("flythrough: no bookmarks to visit"));
+		return(false);
+	}
+	return(true);
+}
+
+void FRenderDocPluginFlythrough::MoveToBookmark()
+{
+	const FBookmark& Bookmark = Bookmarks[CurrentBookmark];
+	UE_LOG(RenderDocPlugin, Log, TEXT("flythrough: moving to bookmark '%s' (%d/%d)"), *Bookmark.Name, CurrentBookmark + 1, Bookmarks.Num());
+
+	Camera->SetActorLocationAndRotation(Bookmark.Location, Bookmark.Rotation);
+	if (APlayerController* PlayerController = World->GetFirstPlayerController())
+		PlayerController->SetViewTarget(Camera.Get());
+
+	State = Settling;
+	StateFrames = 0;
+	StateStartTime = FPlatformTime::Seconds();
+}
+
+void FRenderDocPluginFlythrough::NextBookmark()
+{
+	if (Results.Last().CaptureFile.IsEmpty())
+		UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: no capture for bookmark '%s'"), *Results.Last().Bookmark.Name);
+
+	if (++CurrentBookmark < Bookmarks.Num())
+		MoveToBookmark();
+	else
+		Finish();
+}
+
+bool FRenderDocPluginFlythrough::IsSettled() const
+{
+	if (StateFrames < SettleFrames)
+		return(false);
+	if (IsAsyncLoading())
+		return(false);
+	if (IStreamingManager::Get().GetNumWantingResources() > 0)
+		return(false);
+	if (GShaderCompilingManager && GShaderCompilingManager->IsCompiling())
+		return(false);
+	return(true);
+}
+
+bool FRenderDocPluginFlythrough::Tick(float DeltaTime, FString& OutCaptureLabel)
+{
+	const bool bTimedOut = (FPlatformTime::Seconds() - StateStartTime) > ((State == Requesting || State == Capturing) ? CaptureTimeout : WorldTimeout);
+
+	switch (State)
+	{
+	case Idle :
+		return(false);
+
+	case WaitingForWorld :
+	{
+		UWorld* GameWorld = FindGameWorld();
+		if (!GameWorld || !GameWorld->GetFirstPlayerController())
+		{
+			if (bTimedOut)
+			{
+				UE_LOG(RenderDocPlugin, Error, TEXT("flythrough: no game world with a player within %.0f seconds"), WorldTimeout);
+				Finish();
+			}
+			return(false);
+		}
+
+		World = GameWorld;
+		if (!LoadBookmarks(GameWorld))
+		{
+			Finish();
+			return(false);
+		}
+
+		Camera = GameWorld->SpawnActor<ACameraActor>(Bookmarks[0].Location, Bookmarks[0].Rotation);
+		if (!Camera.IsValid())
+		{
+			UE_LOG(RenderDocPlugin, Error, TEXT("flythrough: unable to spawn the camera"));
+			Finish();
+			return(false);
+		}
+
+		MoveToBookmark();
+		return(false);
+	}
+
+	case Settling :
+	{
+		if (!World.IsValid() || !Camera.IsValid())
+		{
+			UE_LOG(RenderDocPlugin, Error, TEXT("flythrough: the world went away"));
+			Finish();
+			return(false);
+		}
+
+		++StateFrames;
+		const bool bSettled = IsSettled();
+		if (!bSettled && (FPlatformTime::Seconds() - StateStartTime) <= SettleTimeout)
+			return(false);
+
+		if (!bSettled)
+			UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: bookmark '%s' did not settle within %.0f seconds"), *Bookmarks[CurrentBookmark].Name, SettleTimeout);
+
+		FResult& Result = Results[Results.AddZeroed()];
+		Result.Bookmark = Bookmarks[CurrentBookmark];
+		Result.bSettled = bSettled;
+
+		State = Measuring;
+		StateFrames = 0;
+		SumFrameMs = SumGameThreadMs = SumRenderThreadMs = SumGPUMs = 0.0;
+		MinFrameMs = FLT_MAX;
+		MaxFrameMs = 0.0f;
+		return(false);
+	}
+
+	case Measuring :
+	{
+		const float FrameMs = DeltaTime * 1000.0f;
+		SumFrameMs += FrameMs;
+		MinFrameMs = FMath::Min(MinFrameMs, FrameMs);
+		MaxFrameMs = FMath::Max(MaxFrameMs, FrameMs);
+		SumGameThreadMs   += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		SumRenderThreadMs += FPlatformTime::ToMilliseconds(GRenderThreadTime);
+		SumGPUMs          += FPlatformTime::ToMilliseconds(GGPUFrameTime);
+		if (++StateFrames < MeasureFrames)
+			return(false);
+
+		FResult& Result = Results.Last();
+		Result.AvgFrameMs     = (float)(SumFrameMs / StateFrames);
+		Result.MinFrameMs     = MinFrameMs;
+		Result.MaxFrameMs     = MaxFrameMs;
+		Result.GameThreadMs   = (float)(SumGameThreadMs / StateFrames);
+		Result.RenderThreadMs = (float)(SumRenderThreadMs / StateFrames);
+		Result.GPUMs          = (float)(SumGPUMs / StateFrames);
+
+		// Each capture is named after its bookmark; the index keeps the labels of a
+		// run unique, so that a late event never lands on the wrong bookmark:
+		CaptureLabel = FString::Printf(TEXT("Flythrough%02d_%s"), CurrentBookmark + 1, *Result.Bookmark.Name);
+		State = Requesting;
+		StateStartTime = FPlatformTime::Seconds();
+		OutCaptureLabel = CaptureLabel;
+		return(true);
+	}
+
+	case Requesting :
+		// Another capture may be under way; ask again on the next tick:
+		if (bTimedOut)
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: the capture of bookmark '%s' was not accepted within %.0f seconds"), *Bookmarks[CurrentBookmark].Name, CaptureTimeout);
+			NextBookmark();
+			return(false);
+		}
+		OutCaptureLabel = CaptureLabel;
+		return(true);
+
+	case Capturing :
+		if (bTimedOut)
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: the capture of bookmark '%s' did not finish within %.0f seconds"), *Bookmarks[CurrentBookmark].Name, CaptureTimeout);
+			NextBookmark();
+		}
+		return(false);
+	}
+
+	return(false);
+}
+
+void FRenderDocPluginFlythrough::OnCaptureAccepted()
+{
+	if (State != Requesting)
+		return;
+
+	State = Capturing;
+	StateStartTime = FPlatformTime::Seconds();
+}
+
+void FRenderDocPluginFlythrough::OnCaptureEvent(const FRenderDocPluginEvent& Event)
+{
+	if (State != Capturing || Event.Label != CaptureLabel)
+		return;
+
+	if (Event.Stage == ERenderDocCaptureStage::Finished)
+		Results.Last().CaptureFile = Event.CaptureFile;
+	else if (Event.Stage != ERenderDocCaptureStage::Failed)
+		return;
+
+	NextBookmark();
+}
+
+void FRenderDocPluginFlythrough::WriteManifest()
+{
+	FString BuildId;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("RenderDocBuildId="), BuildId))
+		BuildId = FEngineVersion::Current().ToString();
+
+	FString Json;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+
+	Writer->WriteObjectStart(TEXT("build"));
+	Writer->WriteValue(TEXT("id"), BuildId);
+	Writer->WriteValue(TEXT("engine"), FEngineVersion::Current().ToString());
+	Writer->WriteValue(TEXT("changelist"), (int32)FEngineVersion::Current().GetChangelist());
+	Writer->WriteValue(TEXT("game"), FString(FApp::GetGameName()));
+	Writer->WriteValue(TEXT("configuration"), FString(EBuildConfigurations::ToString(FApp::GetBuildConfiguration())));
+	Writer->WriteObjectEnd();
+
+	Writer->WriteValue(TEXT("map"), World.IsValid() ? World->GetMapName() : FString());
+	Writer->WriteValue(TEXT("preset"), Preset);
+	Writer->WriteValue(TEXT("date"), FDateTime::Now().ToIso8601());
+
+	Writer->WriteArrayStart(TEXT("captures"));
+	for (const FResult& Result : Results)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("bookmark"), Result.Bookmark.Name);
+		Writer->WriteValue(TEXT("location"), Result.Bookmark.Location.ToString());
+		Writer->WriteValue(TEXT("rotation"), Result.Bookmark.Rotation.ToString());
+		Writer->WriteValue(TEXT("capture"), Result.CaptureFile);
+		Writer->WriteValue(TEXT("settled"), Result.bSettled);
+		Writer->WriteValue(TEXT("avgFrameMs"), Result.AvgFrameMs);
+		Writer->WriteValue(TEXT("minFrameMs"), Result.MinFrameMs);
+		Writer->WriteValue(TEXT("maxFrameMs"), Result.MaxFrameMs);
+		Writer->WriteValue(TEXT("gameThreadMs"), Result.GameThreadMs);
+		Writer->WriteValue(TEXT("renderThreadMs"), Result.RenderThreadMs);
+		Writer->WriteValue(TEXT("gpuMs"), Result.GPUMs);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	const FString ManifestFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(*FPaths::GameSavedDir(), TEXT("RenderDocCaptures"),
+		*FString::Printf(TEXT("Flythrough_%s.json"), *FDateTime::Now().ToString())));
+	if (FFileHelper::SaveStringToFile(Json, *ManifestFile))
+		UE_LOG(RenderDocPlugin, Log, TEXT("flythrough: manifest written to '%s'"), *ManifestFile);
+	else
+		UE_LOG(RenderDocPlugin, Error, TEXT("flythrough: unable to write manifest '%s'"), *ManifestFile);
+}
+
+void FRenderDocPluginFlythrough::Finish()
+{
+	if (Results.Num() > 0)
+		WriteManifest();
+
+	if (Camera.IsValid())
+		Camera->Destroy();
+	Camera.Reset();
+	World.Reset();
+	CaptureLabel.Empty();
+	State = Idle;
+
+	UE_LOG(RenderDocPlugin, Log, TEXT("flythrough: done (%d of %d bookmarks captured)"),
+		Results.FilterByPredicate([](const FResult& Result) { return(!Result.CaptureFile.IsEmpty()); }).Num(), Bookmarks.Num());
+
+	// Cleared first, as the callback may well start another run:
+	TFunction<void()> Finished = OnFinished;
+	OnFinished = nullptr;
+	if (Finished)
+		Finished();
+
+	if (bExitWhenDone)
+		FPlatformMisc::RequestExit(false);
+}
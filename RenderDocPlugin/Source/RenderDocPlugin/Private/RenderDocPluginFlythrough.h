@@ -0,0 +1,133 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#include "RenderDocPluginEvents.h"
+
+/**
+* Performance-regression harness: moves a camera through a list of bookmarks of
+* the loaded map and captures a frame at each one, so that the same views can be
+* compared from one build to the next. At every bookmark it waits for package
+* loading, texture streaming and shader compilation to settle, measures the frame
+* times for a while, and then asks for a capture. Once every bookmark has been
+* visited, a JSON manifest ties each capture to the build, the map, the bookmark
+* and the frame times measured right before it.
+*
+* Bookmarks are read from a text file, one per line (# starts a comment):
+*
+*   <name> <X> <Y> <Z> <Pitch> <Yaw> <Roll>
+*
+* or, without a file, taken from the bookmarks saved in the map (Ctrl+0..9 in the
+* Editor).
+*/
+class FRenderDocPluginFlythrough
+{
+public:
+	FRenderDocPluginFlythrough();
+
+	/**
+	* Starts the flythrough as soon as a game world with a player is available.
+	* @param BookmarksFile Bookmarks file; empty to use the bookmarks of the map.
+	* @param bExitWhenDone Request the engine to exit once the manifest is written.
+	* @param OnFinished Called once the run is over, whether finished or cancelled.
+	*/
+	void Start(const FString& BookmarksFile, const FString& Preset, bool bExitWhenDone, TFunction<void()> OnFinished);
+
+	/** Ends the run right away, writing the manifest of the bookmarks visited so far. */
+	void Cancel();
+
+	bool IsRunning() const { return(State != Idle); }
+
+	/**
+	* To be called once per engine tick, on the game thread. Returns true when the
+	* camera has settled at the current bookmark and the next frame must be captured
+	* under CaptureLabel; it keeps asking, once per tick, until OnCaptureAccepted().
+	*/
+	bool Tick(float DeltaTime, FString& CaptureLabel);
+
+	/** The capture asked for by Tick() has been accepted. */
+	void OnCaptureAccepted();
+
+	/** Listens to capture progress, to learn about the capture of each bookmark. */
+	void OnCaptureEvent(const FRenderDocPluginEvent& Event);
+
+private:
+	struct FBookmark
+	{
+		FString Name;
+		FVector Location;
+		FRotator Rotation;
+	};
+
+	struct FResult
+	{
+		FBookmark Bookmark;
+		FString CaptureFile;
+		bool bSettled;
+		float AvgFrameMs;
+		float MinFrameMs;
+		float MaxFrameMs;
+		float GameThreadMs;
+		float RenderThreadMs;
+		float GPUMs;
+	};
+
+	enum EState { Idle, WaitingForWorld, Settling, Measuring, Requesting, Capturing };
+
+	UWorld* FindGameWorld() const;
+	bool LoadBookmarks(UWorld* World);
+	void MoveToBookmark();
+	void NextBookmark();
+	bool IsSettled() const;
+	void WriteManifest();
+	void Finish();
+
+	EState State;
+	FString BookmarksFile;
+	FString Preset;
+	bool bExitWhenDone;
+	TFunction<void()> OnFinished;
+
+	TWeakObjectPtr<UWorld> World;
+	TWeakObjectPtr<class ACameraActor> Camera;
+	TArray<FBookmark> Bookmarks;
+	int32 CurrentBookmark;
+	FString CaptureLabel;
+	TArray<FResult> Results;
+
+	// Waiting, settling and frame time measurement of the current bookmark:
+	int32 StateFrames;
+	double StateStartTime;
+	double SumFrameMs, SumGameThreadMs, SumRenderThreadMs, SumGPUMs;
+	float MinFrameMs, MaxFrameMs;
+
+	// Tunables, from the [RenderDoc] section of the game config:
+	int32 SettleFrames;
+	float SettleTimeout;
+	int32 MeasureFrames;
+	float WorldTimeout;
+	float CaptureTimeout;
+};
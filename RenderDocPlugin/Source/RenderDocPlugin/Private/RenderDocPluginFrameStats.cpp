@@ -0,0 +1,76 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginFrameStats.h"
+
+#include "RenderDocPluginModule.h"
+
+/** Takes the sample once the RHI thread has executed every command enqueued before it. */
+struct FRHICommandTakeRenderDocFrameStats : public FRHICommand<FRHICommandTakeRenderDocFrameStats>
+{
+	TFunction<void()> Take;
+
+	FRHICommandTakeRenderDocFrameStats(TFunction<void()>&& InTake) : Take(MoveTemp(InTake)) { }
+
+	void Execute(FRHICommandListBase& CmdList) { Take(); }
+};
+
+void FRenderDocPluginFrameStatsSampler::RequestSample()
+{
+	// Each statistic is read on the thread that writes it; the frame time of the
+	// previous tick is the delta time of this one:
+	FRenderDocFrameStats Stats;
+	FMemory::Memzero(Stats);
+	Stats.Frame = GFrameCounter - 1;
+	Stats.FrameMs = FApp::GetDeltaTime() * 1000.0f;
+	Stats.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+
+	// The RHI counters are accumulated (and reset) by the rendering side; reading
+	// them behind a command enqueued at the start of the game tick yields the
+	// totals of the previous frame, all of whose commands precede this one:
+	ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+		SampleRenderDocFrameStats,
+		FRenderDocPluginFrameStatsSampler*, Sampler, this,
+		FRenderDocFrameStats, Stats, Stats,
+		{
+			FRenderDocFrameStats RenderStats = Stats;
+			RenderStats.RenderThreadMs = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+			if (RHICmdList.Bypass())
+				Sampler->TakeSample(RenderStats);
+			else
+				new (RHICmdList.AllocCommand<FRHICommandTakeRenderDocFrameStats>()) FRHICommandTakeRenderDocFrameStats([Sampler, RenderStats]() { Sampler->TakeSample(RenderStats); });
+		});
+}
+
+void FRenderDocPluginFrameStatsSampler::TakeSample(FRenderDocFrameStats Stats)
+{
+	Stats.DrawCalls            = GNumDrawCallsRHI;
+	Stats.Primitives           = GNumPrimitivesDrawnRHI;
+	Stats.TextureMemoryMB      = GCurrentTextureMemorySize / 1024;
+	Stats.RenderTargetMemoryMB = GCurrentRendertargetMemorySize / 1024;
+	Stats.GPUMs                = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+	Samples.Enqueue(Stats);
+}
@@ -0,0 +1,66 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+/** Render statistics of one engine tick (see FRenderDocPluginFrameStatsSampler). */
+struct FRenderDocFrameStats
+{
+	uint64 Frame;                 // GFrameCounter of the tick measured
+	float FrameMs;                // duration of that tick
+	int32 DrawCalls;
+	int32 Primitives;
+	int32 TextureMemoryMB;
+	int32 RenderTargetMemoryMB;
+	float GameThreadMs;
+	float RenderThreadMs;
+	float GPUMs;                  // latest GPU frame time available (GPU timings lag behind)
+};
+
+/**
+* Samples the render statistics of the previous engine tick. A sample requested
+* at the start of a tick is taken where the RHI commands of the previous tick
+* have all executed (on the RHI thread if there is one, which is where the RHI
+* counters are accumulated), and handed over to the game thread as a whole
+* through a queue, tagged with the frame it measures; nothing is shared between
+* the threads but the queue.
+*/
+class FRenderDocPluginFrameStatsSampler
+{
+public:
+	/** To be called at the start of the engine tick, on the game thread. */
+	void RequestSample();
+
+	/** Game thread; the samples come out in frame order, a tick or two after being requested. */
+	bool Dequeue(FRenderDocFrameStats& OutStats) { return(Samples.Dequeue(OutStats)); }
+
+	/** Drops the samples not dequeued yet. */
+	void Reset() { Samples.Empty(); }
+
+private:
+	void TakeSample(FRenderDocFrameStats Stats);
+
+	TQueue<FRenderDocFrameStats, EQueueMode::Mpsc> Samples;
+};
@@ -0,0 +1,249 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginHUD.h"
+
+#if RENDERDOC_PLUGIN_HUD
+
+#include "RenderDocPluginModule.h"
+
+#include "Debug/DebugDrawService.h"
+#include "CanvasTypes.h"
+#if RENDERDOC_PLUGIN_SLATE
+#include "SWindow.h"
+#endif//RENDERDOC_PLUGIN_SLATE
+
+static const TCHAR* StageNames [] =
+{
+	TEXT("capture requested"),
+	TEXT("capturing"),
+	TEXT("writing capture"),
+	TEXT("moving capture out of scratch"),
+	TEXT("launching RenderDoc GUI"),
+	TEXT("capture ready"),
+	TEXT("capture failed"),
+	TEXT("archiving capture"),
+	TEXT("capture archived"),
+};
+
+// Seconds the final status stays on screen:
+static const double LingerSeconds = 5.0;
+
+static const double BytesPerMB = 1024.0 * 1024.0;
+
+FRenderDocPluginHUD::FRenderDocPluginHUD()
+	: bEnabled(true)
+	, Stage(ERenderDocCaptureStage::Finished)
+	, CaptureStartTime(0.0)
+	, StageTime(0.0)
+	, BytesWritten(-1)
+	, BytesTotal(-1)
+	, RangeFrames(0)
+	, RangeMaxFrames(0)
+	, bWasCapturing(false)
+	, IdleFrameMs(0.0f)
+	, CaptureFrameMs(0.0f)
+	, CaptureFrames(0)
+	, bWindowTitleOverridden(false)
+	, LastCountdownTime(0.0)
+{
+	FMemory::Memzero(Lines);
+	FMemory::Memzero(WindowTitle);
+
+	if (GConfig)
+		GConfig->GetBool(TEXT("RenderDoc"), TEXT("ShowHUD"), bEnabled, GGameIni);
+}
+
+void FRenderDocPluginHUD::Listen(FRenderDocPluginEventChannel& Channel)
+{
+	CaptureEventHandle = Channel.OnCaptureEvent().AddRaw(this, &FRenderDocPluginHUD::OnCaptureEvent);
+}
+
+void FRenderDocPluginHUD::Ignore(FRenderDocPluginEventChannel& Channel)
+{
+	Channel.OnCaptureEvent().Remove(CaptureEventHandle);
+	UpdateWindowTitle(false);
+	Hide();
+}
+
+void FRenderDocPluginHUD::SetEnabled(bool bInEnabled)
+{
+	if (!bInEnabled)
+	{
+		UpdateWindowTitle(false);
+		Hide();
+	}
+	bEnabled = bInEnabled;
+}
+
+void FRenderDocPluginHUD::Show()
+{
+	// The editor has its own notification:
+	if (!bEnabled || GIsEditor || DrawHandle.IsValid())
+		return;
+	DrawHandle = UDebugDrawService::Register(TEXT("Game"), FDebugDrawDelegate::CreateRaw(this, &FRenderDocPluginHUD::Draw));
+}
+
+void FRenderDocPluginHUD::Hide()
+{
+	if (!DrawHandle.IsValid())
+		return;
+	UDebugDrawService::Unregister(DrawHandle);
+	DrawHandle.Reset();
+}
+
+bool FRenderDocPluginHUD::IsDone() const
+{
+	return((Stage == ERenderDocCaptureStage::Finished) || (Stage == ERenderDocCaptureStage::Failed) || (Stage == ERenderDocCaptureStage::Archived));
+}
+
+void FRenderDocPluginHUD::OnCaptureEvent(const FRenderDocPluginEvent& Event)
+{
+	if (Event.Stage == ERenderDocCaptureStage::Requested)
+	{
+		CaptureStartTime = Event.Timestamp;
+		BytesWritten = BytesTotal = -1;
+		RangeFrames = RangeMaxFrames = 0;
+	}
+	Stage = Event.Stage;
+	StageTime = Event.Timestamp;
+	if (Event.BytesWritten >= 0)
+	{
+		BytesWritten = Event.BytesWritten;
+		BytesTotal = Event.BytesTotal;
+	}
+	Show();
+}
+
+void FRenderDocPluginHUD::OnFrame(float DeltaTime, bool bCapturing, uint64 InRangeFrames, uint64 InRangeMaxFrames)
+{
+	// DeltaTime is the duration of the previous tick, so it is accounted to the
+	// state of the previous call:
+	const float FrameMs = DeltaTime * 1000.0f;
+	if (bWasCapturing)
+		CaptureFrameMs += (FrameMs - CaptureFrameMs) / ++CaptureFrames;
+	else if (FrameMs > 0.0f)
+		IdleFrameMs = (IdleFrameMs > 0.0f) ? IdleFrameMs + (FrameMs - IdleFrameMs) * 0.05f : FrameMs;
+
+	if (bCapturing && !bWasCapturing)
+	{
+		CaptureFrameMs = 0.0f;
+		CaptureFrames = 0;
+	}
+	bWasCapturing = bCapturing;
+	if (InRangeFrames > 0)
+	{
+		RangeFrames = InRangeFrames;
+		RangeMaxFrames = InRangeMaxFrames;
+	}
+	UpdateWindowTitle(bCapturing && InRangeFrames > 0);
+
+	// Unregistered from here rather than from Draw(), while the draw delegates of
+	// the debug draw service are not being iterated:
+	if (DrawHandle.IsValid() && !bCapturing && IsDone() && (FPlatformTime::Seconds() - StageTime) > LingerSeconds)
+		Hide();
+}
+
+void FRenderDocPluginHUD::UpdateWindowTitle(bool bRecordingRange)
+{
+	if (!bWindowTitleOverridden && (!bRecordingRange || !bEnabled || GIsEditor))
+		return;
+
+	if (bRecordingRange && RangeMaxFrames > 0)
+		FCString::Snprintf(Lines[0], MaxLineLength, TEXT("RenderDoc: recording range, %llu of %llu frames remaining"), RangeMaxFrames - FMath::Min(RangeFrames, RangeMaxFrames), RangeMaxFrames);
+	else if (bRecordingRange)
+		FCString::Snprintf(Lines[0], MaxLineLength, TEXT("RenderDoc: recording range, %llu frames recorded"), RangeFrames);
+
+#if RENDERDOC_PLUGIN_SLATE
+	TSharedPtr<SWindow> Window;
+	if (GEngine && GEngine->GameViewport)
+		Window = GEngine->GameViewport->GetWindow();
+	if (!Window.IsValid() || !Window->GetNativeWindow().IsValid())
+		return;
+
+	if (!bRecordingRange)
+	{
+		Window->GetNativeWindow()->SetText(*SavedWindowTitle);
+		bWindowTitleOverridden = false;
+		return;
+	}
+
+	// Saved once per range; from then on, the title is formatted into a fixed buffer:
+	if (!bWindowTitleOverridden)
+	{
+		SavedWindowTitle = Window->GetTitle().ToString();
+		bWindowTitleOverridden = true;
+	}
+	FCString::Snprintf(WindowTitle, ARRAY_COUNT(WindowTitle), TEXT("%s - %s"), *SavedWindowTitle, Lines[0]);
+	Window->GetNativeWindow()->SetText(WindowTitle);
+#else
+	bWindowTitleOverridden = bRecordingRange;
+	const double Now = FPlatformTime::Seconds();
+	if (bRecordingRange && (Now - LastCountdownTime) >= 1.0)
+	{
+		UE_LOG(RenderDocPlugin, Log, TEXT("%s"), Lines[0]);
+		LastCountdownTime = Now;
+	}
+#endif//RENDERDOC_PLUGIN_SLATE
+}
+
+void FRenderDocPluginHUD::Draw(UCanvas* Canvas, APlayerController* PlayerController)
+{
+	if (!Canvas || !Canvas->Canvas || !GEngine)
+		return;
+
+	// The debug draw service draws within the frame, so a capture in flight would
+	// record the HUD along with the scene; scoped captures are only known from
+	// their events:
+	if (bWasCapturing || Stage == ERenderDocCaptureStage::Requested || Stage == ERenderDocCaptureStage::Capturing)
+		return;
+
+	int32 NumLines (0);
+	const double Elapsed = (IsDone() ? StageTime : FPlatformTime::Seconds()) - CaptureStartTime;
+	FCString::Snprintf(Lines[NumLines++], MaxLineLength, TEXT("RenderDoc: %s (%.1f s)"), StageNames[(int32)Stage], Elapsed);
+
+	if (RangeFrames > 0 && RangeMaxFrames > 0)
+		FCString::Snprintf(Lines[NumLines++], MaxLineLength, TEXT("frames recorded: %llu (at most %llu)"), RangeFrames, RangeMaxFrames);
+	else if (RangeFrames > 0)
+		FCString::Snprintf(Lines[NumLines++], MaxLineLength, TEXT("frames recorded: %llu"), RangeFrames);
+
+	if (BytesWritten >= 0 && BytesTotal > 0)
+		FCString::Snprintf(Lines[NumLines++], MaxLineLength, TEXT("written: %.1f of %.1f MB"), BytesWritten / BytesPerMB, BytesTotal / BytesPerMB);
+	else if (BytesWritten >= 0)
+		FCString::Snprintf(Lines[NumLines++], MaxLineLength, TEXT("written: %.1f MB"), BytesWritten / BytesPerMB);
+
+	if (CaptureFrames > 0 && IdleFrameMs > 0.0f)
+		FCString::Snprintf(Lines[NumLines++], MaxLineLength, TEXT("hook tax: %+.2f ms/frame (%.2f ms capturing, %.2f ms before)"), CaptureFrameMs - IdleFrameMs, CaptureFrameMs, IdleFrameMs);
+
+	const UFont* Font = GEngine->GetSmallFont();
+	const FLinearColor Color = (Stage == ERenderDocCaptureStage::Failed) ? FLinearColor::Red : FLinearColor::Yellow;
+	const float LineHeight = Font->GetMaxCharHeight();
+	float Y = Canvas->ClipY * 0.1f;
+	for (int32 i = 0; i < NumLines; ++i, Y += LineHeight)
+		Canvas->Canvas->DrawShadowedString(Canvas->ClipX * 0.02f, Y, Lines[i], Font, Color);
+}
+
+#endif//RENDERDOC_PLUGIN_HUD
@@ -0,0 +1,114 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+// In-viewport capture status for game builds; define RENDERDOC_PLUGIN_HUD=0 (e.g.
+// in RenderDocPlugin.Build.cs) to compile it out entirely:
+#ifndef RENDERDOC_PLUGIN_HUD
+#define RENDERDOC_PLUGIN_HUD !UE_BUILD_SHIPPING
+#endif
+
+#if RENDERDOC_PLUGIN_HUD
+
+#include "RenderDocPluginEvents.h"
+
+class UCanvas;
+class APlayerController;
+
+/**
+* Capture status drawn over the game viewport of standalone and game processes
+* (the editor shows a notification instead): the stage of the capture, the frames
+* recorded by a range capture, the bytes written, and the frame time tax of the
+* RenderDoc hook, measured as the average game frame time while capturing minus
+* the (exponential moving) average of the frames before. Nothing is drawn while
+* frames are being recorded, since the HUD would end up in the capture; a range
+* capture counts its remaining frames down in the title of the game window
+* instead, which is not part of any frame (or in the log, without Slate: see
+* RENDERDOC_PLUGIN_SLATE in RenderDocPlugin.Build.cs).
+*
+* The draw delegate is only registered from the first capture event until a few
+* seconds after the last one, and every line is formatted into a fixed buffer, so
+* that the HUD does not allocate per frame, and costs nothing while idle.
+*/
+class FRenderDocPluginHUD
+{
+public:
+	FRenderDocPluginHUD();
+
+	void Listen(FRenderDocPluginEventChannel& Channel);
+	void Ignore(FRenderDocPluginEventChannel& Channel);
+
+	bool IsEnabled() const { return(bEnabled); }
+	void SetEnabled(bool bInEnabled);
+
+	/**
+	* To be called once per engine tick, on the game thread, once the capture of the
+	* tick (if any) has begun. DeltaTime measures the previous tick.
+	*/
+	void OnFrame(float DeltaTime, bool bCapturing, uint64 InRangeFrames, uint64 InRangeMaxFrames);
+
+private:
+	enum { MaxLines = 4, MaxLineLength = 128 };
+
+	void OnCaptureEvent(const FRenderDocPluginEvent& Event);
+	void Draw(UCanvas* Canvas, APlayerController* PlayerController);
+	void Show();
+	void Hide();
+	bool IsDone() const;
+	void UpdateWindowTitle(bool bRecordingRange);
+
+	bool bEnabled;
+	FDelegateHandle CaptureEventHandle;
+	FDelegateHandle DrawHandle;
+
+	// Latest capture event (no strings, copying them would allocate):
+	ERenderDocCaptureStage Stage;
+	double CaptureStartTime;
+	double StageTime;
+	int64 BytesWritten;
+	int64 BytesTotal;
+
+	// Frames recorded by the latest range capture, kept once it has ended:
+	uint64 RangeFrames;
+	uint64 RangeMaxFrames;
+
+	// Frame time tax of the hook; bWasCapturing is also true while a capture is
+	// armed or under way (see OnFrame):
+	bool bWasCapturing;
+	float IdleFrameMs;
+	float CaptureFrameMs;
+	int32 CaptureFrames;
+
+	// Title of the game window, saved while a range capture overrides it:
+	FString SavedWindowTitle;
+	bool bWindowTitleOverridden;
+	double LastCountdownTime;
+
+	TCHAR Lines [MaxLines][MaxLineLength];
+	TCHAR WindowTitle [MaxLineLength * 2];
+};
+
+#endif//RENDERDOC_PLUGIN_HUD
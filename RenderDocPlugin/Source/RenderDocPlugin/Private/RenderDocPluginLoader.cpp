@@ -26,19 +26,56 @@
 #include "RenderDocPluginPrivatePCH.h"
 #include "RenderDocPluginLoader.h"
 
-#include "WindowsHWrapper.h"
-
 #include "RenderDocPluginModule.h"
 
 #include "Internationalization.h"
 
+#if WITH_EDITOR
 #include "Developer/DesktopPlatform/public/DesktopPlatformModule.h"
+#endif//WITH_EDITOR
 
+#if PLATFORM_WINDOWS
 #include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
 #include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX
+#include <dlfcn.h>
+#endif
 
 #define LOCTEXT_NAMESPACE "RenderDocLoaderPluginNamespace" 
 
+const TCHAR* FRenderDocPluginLoader::GetLibraryName()
+{
+#if PLATFORM_LINUX
+	return(TEXT("librenderdoc.so"));
+#else
+	return(TEXT("renderdoc.dll"));
+#endif
+}
+
+static bool GetRenderDocAPI(void* RenderDocDLL, FRenderDocPluginLoader::RENDERDOC_API_CONTEXT*& RenderDocAPI)
+{
+	pRENDERDOC_GetAPI RENDERDOC_GetAPI = (pRENDERDOC_GetAPI)FPlatformProcess::GetDllExport(RenderDocDLL, TEXT("RENDERDOC_GetAPI"));
+	if (!RENDERDOC_GetAPI)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("unable to obtain 'RENDERDOC_GetAPI' function from '%s'. You are likely using an incompatible version of RenderDoc."), FRenderDocPluginLoader::GetLibraryName());
+		return(false);
+	}
+
+	// Version checking and reporting
+	if (0 == RENDERDOC_GetAPI(eRENDERDOC_API_Version_1_0_0, (void**)&RenderDocAPI))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("unable to initialize RenderDoc library due to API incompatibility (plugin requires eRENDERDOC_API_Version_1_0_0)."));
+		RenderDocAPI = nullptr;
+		return(false);
+	}
+
+	int major(0), minor(0), patch(0);
+	RenderDocAPI->GetAPIVersion(&major, &minor, &patch);
+	UE_LOG(RenderDocPlugin, Log, TEXT("RenderDoc library has been loaded (RenderDoc API v%i.%i.%i)."), major, minor, patch);
+	return(true);
+}
+
 static void* LoadAndCheckRenderDocLibrary(FRenderDocPluginLoader::RENDERDOC_API_CONTEXT*& RenderDocAPI, const FString& RenderdocPath)
 {
 	check(nullptr == RenderDocAPI);
@@ -46,7 +83,7 @@ static void* LoadAndCheckRenderDocLibrary(FRenderDocPluginLoader::RENDERDOC_API_
 	if (RenderdocPath.IsEmpty())
 		return(nullptr);
 
-	FString PathToRenderDocDLL = FPaths::Combine(*RenderdocPath, *FString("renderdoc.dll"));
+	FString PathToRenderDocDLL = FPaths::Combine(*RenderdocPath, FRenderDocPluginLoader::GetLibraryName());
 	if (!FPaths::FileExists(PathToRenderDocDLL))
 	{
 		UE_LOG(RenderDocPlugin, Warning, TEXT("unable to locate RenderDoc library at: %s"), *PathToRenderDocDLL);
@@ -62,29 +99,31 @@ static void* LoadAndCheckRenderDocLibrary(FRenderDocPluginLoader::RENDERDOC_API_
 		return(nullptr);
 	}
 
-	pRENDERDOC_GetAPI RENDERDOC_GetAPI = (pRENDERDOC_GetAPI)FPlatformProcess::GetDllExport(RenderDocDLL, TEXT("RENDERDOC_GetAPI"));
-	if (!RENDERDOC_GetAPI)
+	if (!GetRenderDocAPI(RenderDocDLL, RenderDocAPI))
 	{
-		UE_LOG(RenderDocPlugin, Warning, TEXT("unable to obtain 'RENDERDOC_GetAPI' function from 'renderdoc.dll'. You are likely using an incompatible version of RenderDoc."), *PathToRenderDocDLL);
 		FPlatformProcess::FreeDllHandle(RenderDocDLL);
 		return(nullptr);
 	}
 
-	// Version checking and reporting
-	if (0 == RENDERDOC_GetAPI(eRENDERDOC_API_Version_1_0_0, (void**)&RenderDocAPI))
-	{
-		UE_LOG(RenderDocPlugin, Warning, TEXT("unable to initialize RenderDoc library due to API incompatibility (plugin requires eRENDERDOC_API_Version_1_0_0)."), *PathToRenderDocDLL);
-		FPlatformProcess::FreeDllHandle(RenderDocDLL);
-		return(nullptr);
-	}
-
-	int major(0), minor(0), patch(0);
-	RenderDocAPI->GetAPIVersion(&major, &minor, &patch);
-	UE_LOG(RenderDocPlugin, Log, TEXT("RenderDoc library has been loaded (RenderDoc API v%i.%i.%i)."), major, minor, patch);
-
 	return(RenderDocDLL);
 }
 
+/**
+* The RenderDoc library is already part of the process when the process has been
+* launched from RenderDoc (or renderdoccmd on a headless node); it must then be used
+* as is, since it has hooked the graphics API right from the start.
+*/
+static void* GetLoadedRenderDocLibrary()
+{
+#if PLATFORM_WINDOWS
+	return(GetModuleHandleW(FRenderDocPluginLoader::GetLibraryName()));
+#elif PLATFORM_LINUX
+	return(dlopen("librenderdoc.so", RTLD_NOW | RTLD_NOLOAD));
+#else
+	return(nullptr);
+#endif
+}
+
 static void UpdateConfigFiles(const FString& RenderdocPath)
 {
 	if (GConfig)
@@ -105,19 +144,34 @@ void FRenderDocPluginLoader::Initialize()
 		return;
 	}
 	
-	// Look for a renderdoc.dll somewhere in the system:
-	UE_LOG(RenderDocPlugin, Log, TEXT("locating RenderDoc library (renderdoc.dll)..."));
+	// Look for a RenderDoc library somewhere in the system:
+	UE_LOG(RenderDocPlugin, Log, TEXT("locating RenderDoc library (%s)..."), GetLibraryName());
 	RenderDocDLL = RenderDocAPI = NULL;
+	bLibraryOwned = true;
+
+	// 0) Check whether the process has been launched from RenderDoc:
+	if (void* LoadedDLL = GetLoadedRenderDocLibrary())
+	{
+		if (GetRenderDocAPI(LoadedDLL, RenderDocAPI))
+		{
+			UE_LOG(RenderDocPlugin, Log, TEXT("using the RenderDoc library this process has been launched with."));
+			RenderDocDLL = LoadedDLL;
+			// GetModuleHandle() does not take a reference, unlike dlopen(RTLD_NOLOAD):
+			bLibraryOwned = (PLATFORM_LINUX != 0);
+		}
+	}
 
 	// 1) Check the Game configuration files:
-	if (GConfig)
+	if (!RenderDocDLL && GConfig)
 	{
 		FString RenderdocPath;
 		GConfig->GetString(TEXT("RenderDoc"), TEXT("BinaryPath"), RenderdocPath, GGameIni);
 		RenderDocDLL = LoadAndCheckRenderDocLibrary(RenderDocAPI, RenderdocPath);
 	}
 
-	// 2) Check for a RenderDoc system installation in the registry:
+	// 2) Check for a RenderDoc system installation: in the registry on Windows, and
+	// in the library search path (/usr/lib, LD_LIBRARY_PATH...) on Linux:
+#if PLATFORM_WINDOWS
 	if (!RenderDocDLL)
 	{
 		FString RenderdocPath;
@@ -126,7 +180,18 @@ void FRenderDocPluginLoader::Initialize()
 		if (RenderDocDLL)
 			UpdateConfigFiles(RenderdocPath);
 	}
+#elif PLATFORM_LINUX
+	if (!RenderDocDLL)
+	{
+		void* SystemDLL = dlopen("librenderdoc.so", RTLD_NOW);
+		if (SystemDLL && GetRenderDocAPI(SystemDLL, RenderDocAPI))
+			RenderDocDLL = SystemDLL;
+		else if (SystemDLL)
+			dlclose(SystemDLL);
+	}
+#endif
 
+#if WITH_EDITOR
 	// 3) Check for a RenderDoc custom installation by prompting the user:
 	if (!RenderDocDLL)
 	{
@@ -138,7 +203,11 @@ void FRenderDocPluginLoader::Initialize()
 		IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
 		if (DesktopPlatform)
 		{
+#if PLATFORM_WINDOWS
 			FString Filter = TEXT("Renderdoc executable|renderdocui.exe");
+#else
+			FString Filter = FString::Printf(TEXT("RenderDoc library|%s"), GetLibraryName());
+#endif
 			TArray<FString> OutFiles;
 			if (DesktopPlatform->OpenFileDialog(NULL, TEXT("Locate main Renderdoc executable... You can find the latest builds at https://renderdoc.org/builds"), TEXT(""), TEXT(""), Filter, EFileDialogFlags::None, OutFiles))
 				RenderdocPath = OutFiles[0];
@@ -148,6 +217,7 @@ void FRenderDocPluginLoader::Initialize()
 		if (RenderDocDLL)
 			UpdateConfigFiles(RenderdocPath);
 	}
+#endif//WITH_EDITOR
 
 	// 4) All bets are off; aborting...
 	if (!RenderDocDLL)
@@ -164,7 +234,7 @@ void FRenderDocPluginLoader::Release()
 	if (GUsingNullRHI)
 		return;
 
-	if (RenderDocDLL)
+	if (RenderDocDLL && bLibraryOwned)
 		FPlatformProcess::FreeDllHandle(RenderDocDLL);
 
 	UE_LOG(RenderDocPlugin, Log, TEXT("plugin has been unloaded."));
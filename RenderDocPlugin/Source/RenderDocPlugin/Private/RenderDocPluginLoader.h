@@ -30,16 +30,22 @@
 class FRenderDocPluginLoader
 {
 public:
+	FRenderDocPluginLoader() : RenderDocDLL(NULL), RenderDocAPI(NULL), bLibraryOwned(false) { }
+
 	void Initialize();
 	void Release();
 
 	typedef RENDERDOC_API_1_0_0 RENDERDOC_API_CONTEXT;
 
+	/** File name of the RenderDoc library on this platform (renderdoc.dll, librenderdoc.so). */
+	static const TCHAR* GetLibraryName();
+
 private:
 	friend class FRenderDocPluginModule;
 	friend class SRenderDocPluginSettingsEditorWindow;
 
 	void* RenderDocDLL;
 	RENDERDOC_API_CONTEXT* RenderDocAPI;
+	bool bLibraryOwned;   // false if RenderDoc was already loaded into the process (launched from RenderDoc)
 };
 
@@ -0,0 +1,260 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginMedianCapture.h"
+
+#include "RenderDocPluginModule.h"
+
+#include "Json.h"
+
+static const TCHAR* StatNames [] = { TEXT("FrameMs"), TEXT("DrawCalls"), TEXT("GameThreadMs"), TEXT("RenderThreadMs"), TEXT("GPUMs") };
+
+FRenderDocPluginMedianCapture::FRenderDocPluginMedianCapture()
+	: State(Idle)
+	, WindowFrames(0)
+	, ArmedFrames(0)
+	, SteadyFrames(0)
+	, ArmDistance(0.0f)
+	, ArmedDistance(0.0f)
+	, ArmedRank(0.0f)
+	, ConfigWindowFrames(300)
+	, Percentile(10.0f)
+	, RequiredSteadyFrames(3)
+{
+	FMemory::Memzero(Median);
+	FMemory::Memzero(Spread);
+	FMemory::Memzero(ArmedValues);
+
+	if (!GConfig)
+		return;
+
+	GConfig->GetInt  (TEXT("RenderDoc"), TEXT("MedianCaptureWindow"),       ConfigWindowFrames,   GGameIni);
+	GConfig->GetFloat(TEXT("RenderDoc"), TEXT("MedianCapturePercentile"),   Percentile,           GGameIni);
+	GConfig->GetInt  (TEXT("RenderDoc"), TEXT("MedianCaptureSteadyFrames"), RequiredSteadyFrames, GGameIni);
+	ConfigWindowFrames = FMath::Max(1, ConfigWindowFrames);
+	Percentile = FMath::Clamp(Percentile, 0.0f, 100.0f);
+	RequiredSteadyFrames = FMath::Max(1, RequiredSteadyFrames);
+}
+
+bool FRenderDocPluginMedianCapture::Start(int32 InWindowFrames)
+{
+	if (IsRunning())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("median capture: already running"));
+		return(false);
+	}
+
+	WindowFrames = (InWindowFrames > 0) ? InWindowFrames : ConfigWindowFrames;
+	for (int32 i = 0; i < NumStats; ++i)
+	{
+		Window[i].Reset();
+		Window[i].Reserve(WindowFrames);
+	}
+	Scratch.Reset();
+	Scratch.Reserve(WindowFrames);
+	WindowDistances.Reset();
+	WindowDistances.Reserve(WindowFrames);
+
+	Sampler.Reset();
+	State = Sampling;
+	UE_LOG(RenderDocPlugin, Log, TEXT("median capture: sampling %d frames"), WindowFrames);
+	return(true);
+}
+
+void FRenderDocPluginMedianCapture::Cancel()
+{
+	Sampler.Reset();
+	State = Idle;
+}
+
+bool FRenderDocPluginMedianCapture::Tick(FString& CaptureLabel)
+{
+	if (State != Sampling && State != Armed)
+		return(false);
+
+	Sampler.RequestSample();
+
+	// Each sample holds the frame time and the render statistics of one and the
+	// same frame; every frame sampled since the last tick is scored, in order:
+	FRenderDocFrameStats Stats;
+	while (Sampler.Dequeue(Stats))
+	{
+		const float Values [NumStats] = { Stats.FrameMs, (float)Stats.DrawCalls, Stats.GameThreadMs, Stats.RenderThreadMs, Stats.GPUMs };
+		if (AddSample(Values, CaptureLabel))
+		{
+			Sampler.Reset();
+			return(true);
+		}
+	}
+	return(false);
+}
+
+bool FRenderDocPluginMedianCapture::AddSample(const float* Values, FString& CaptureLabel)
+{
+	if (State == Sampling)
+	{
+		for (int32 i = 0; i < NumStats; ++i)
+			Window[i].Add(Values[i]);
+		if (Window[0].Num() < WindowFrames)
+			return(false);
+
+		ComputeMedians();
+		ArmedFrames = 0;
+		SteadyFrames = 0;
+		State = Armed;
+		UE_LOG(RenderDocPlugin, Log, TEXT("median capture: medians %.2f ms, %.0f draws, game %.2f ms, render %.2f ms, GPU %.2f ms; waiting for a typical frame"),
+			Median[FrameMs], Median[DrawCalls], Median[GameThreadMs], Median[RenderThreadMs], Median[GPUMs]);
+		return(false);
+	}
+
+	const float Distance = GetDistance(Values);
+	SteadyFrames = (Distance <= ArmDistance) ? SteadyFrames + 1 : 0;
+	if (SteadyFrames < RequiredSteadyFrames)
+	{
+		// The scene may have drifted since the window was sampled; relax the bar
+		// rather than wait forever:
+		if (++ArmedFrames >= WindowFrames)
+		{
+			ArmDistance *= 1.5f;
+			ArmedFrames = 0;
+			UE_LOG(RenderDocPlugin, Warning, TEXT("median capture: no typical frame in %d frames; accepting frames up to %.2f from the median"), WindowFrames, ArmDistance);
+		}
+		return(false);
+	}
+
+	FMemory::Memcpy(ArmedValues, Values, sizeof(ArmedValues));
+	ArmedDistance = Distance;
+	ArmedRank = GetPercentileRank(Distance);
+	CaptureLabel = FString::Printf(TEXT("Median_P%d"), FMath::RoundToInt(ArmedRank));
+	State = Capturing;
+	UE_LOG(RenderDocPlugin, Log, TEXT("median capture: frame more typical than %.0f%% of the window (distance %.2f); capturing the next frame"), ArmedRank, ArmedDistance);
+	return(true);
+}
+
+void FRenderDocPluginMedianCapture::ComputeMedians()
+{
+	const int32 Count = Window[0].Num();
+	for (int32 i = 0; i < NumStats; ++i)
+	{
+		Scratch = Window[i];
+		Scratch.Sort();
+		Median[i] = Scratch[Count / 2];
+
+		for (int32 j = 0; j < Count; ++j)
+			Scratch[j] = FMath::Abs(Window[i][j] - Median[i]);
+		Scratch.Sort();
+
+		// Median absolute deviation, scaled to match a standard deviation; the floor
+		// keeps (nearly) constant statistics, such as a GPU timer the RHI does not
+		// implement, from dominating the distance:
+		Spread[i] = FMath::Max(Scratch[Count / 2] * 1.4826f, FMath::Max(FMath::Abs(Median[i]) * 0.01f, 0.01f));
+	}
+
+	float Values [NumStats];
+	WindowDistances.Reset();
+	for (int32 j = 0; j < Count; ++j)
+	{
+		for (int32 i = 0; i < NumStats; ++i)
+			Values[i] = Window[i][j];
+		WindowDistances.Add(GetDistance(Values));
+	}
+	WindowDistances.Sort();
+
+	const int32 ArmIndex = FMath::Clamp(FMath::FloorToInt(Count * Percentile / 100.0f), 0, Count - 1);
+	ArmDistance = WindowDistances[ArmIndex];
+}
+
+float FRenderDocPluginMedianCapture::GetDistance(const float* Values) const
+{
+	float Sum (0.0f);
+	for (int32 i = 0; i < NumStats; ++i)
+		Sum += FMath::Square((Values[i] - Median[i]) / Spread[i]);
+	return(FMath::Sqrt(Sum / NumStats));
+}
+
+float FRenderDocPluginMedianCapture::GetPercentileRank(float Distance) const
+{
+	int32 Farther (0);
+	for (float WindowDistance : WindowDistances)
+		Farther += (WindowDistance > Distance) ? 1 : 0;
+	return(100.0f * Farther / FMath::Max(1, WindowDistances.Num()));
+}
+
+void FRenderDocPluginMedianCapture::OnCaptureEvent(const FRenderDocPluginEvent& Event)
+{
+	if (State != Capturing)
+		return;
+
+	if (Event.Stage == ERenderDocCaptureStage::Finished)
+	{
+		WriteSidecar(Event.CaptureFile);
+		UE_LOG(RenderDocPlugin, Log, TEXT("median capture: done (%s)"), *Event.CaptureFile);
+	}
+	else if (Event.Stage == ERenderDocCaptureStage::Failed)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("median capture: the capture failed (%s)"), *Event.Message);
+	}
+	else
+	{
+		return;
+	}
+
+	State = Idle;
+}
+
+void FRenderDocPluginMedianCapture::WriteSidecar(const FString& CaptureFile) const
+{
+	FString Json;
+	TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+
+	Writer->WriteValue(TEXT("engine"), FEngineVersion::Current().ToString());
+	Writer->WriteValue(TEXT("date"), FDateTime::Now().ToIso8601());
+	Writer->WriteValue(TEXT("capture"), CaptureFile);
+	Writer->WriteValue(TEXT("windowFrames"), WindowFrames);
+	Writer->WriteValue(TEXT("percentile"), Percentile);
+	Writer->WriteValue(TEXT("rank"), ArmedRank);
+	Writer->WriteValue(TEXT("distance"), ArmedDistance);
+	Writer->WriteValue(TEXT("armDistance"), ArmDistance);
+
+	Writer->WriteObjectStart(TEXT("stats"));
+	for (int32 i = 0; i < NumStats; ++i)
+	{
+		Writer->WriteObjectStart(StatNames[i]);
+		Writer->WriteValue(TEXT("median"), Median[i]);
+		Writer->WriteValue(TEXT("spread"), Spread[i]);
+		Writer->WriteValue(TEXT("armedFrame"), ArmedValues[i]);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteObjectEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	const FString SidecarFile = FPaths::ChangeExtension(CaptureFile, TEXT("median.json"));
+	if (!FFileHelper::SaveStringToFile(Json, *SidecarFile))
+		UE_LOG(RenderDocPlugin, Warning, TEXT("median capture: unable to write '%s'"), *SidecarFile);
+}
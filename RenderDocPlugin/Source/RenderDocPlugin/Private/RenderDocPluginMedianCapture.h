@@ -0,0 +1,113 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#include "RenderDocPluginEvents.h"
+#include "RenderDocPluginFrameStats.h"
+
+/**
+* Median-frame capture: captures a typical frame rather than an outlier, for
+* baseline cost reviews. A window of frames is sampled first (frame time, draw
+* calls, game/render thread times and GPU time); every frame is then scored by
+* its distance to the window median, each statistic normalized by its median
+* absolute deviation. Once a few consecutive frames score among the most typical
+* of the window, the next frame is captured.
+*
+* Since a frame is only measured once rendered, the capture is armed from the
+* frames preceding it (the captured frame itself pays for the RenderDoc hook).
+* The capture is named after its representativeness ("Median_P<rank>": the frame
+* before it was more typical than <rank>% of the window), and a sidecar lists the
+* medians and scores next to it:
+*
+*   <capture>.median.json
+*
+*   [RenderDoc]
+*   MedianCaptureWindow=300       ; frames sampled before arming
+*   MedianCapturePercentile=10    ; arm on frames among the 10% most typical ones
+*   MedianCaptureSteadyFrames=3   ; consecutive typical frames required
+*/
+class FRenderDocPluginMedianCapture
+{
+public:
+	FRenderDocPluginMedianCapture();
+
+	/**
+	* Starts sampling a window of frames.
+	* @param InWindowFrames Frames to sample; the configured window if 0.
+	* @return False if a median capture is already running.
+	*/
+	bool Start(int32 InWindowFrames = 0);
+
+	void Cancel();
+
+	bool IsRunning() const { return(State != Idle); }
+
+	/**
+	* To be called once per engine tick, on the game thread. Returns true when the
+	* next frame must be captured, along with the label of that capture.
+	*/
+	bool Tick(FString& CaptureLabel);
+
+	/** Listens to capture progress, to write the sidecar of the capture. */
+	void OnCaptureEvent(const FRenderDocPluginEvent& Event);
+
+private:
+	enum EStat { FrameMs, DrawCalls, GameThreadMs, RenderThreadMs, GPUMs, NumStats };
+
+	enum EState { Idle, Sampling, Armed, Capturing };
+
+	bool AddSample(const float* Values, FString& CaptureLabel);
+	void ComputeMedians();
+	float GetDistance(const float* Values) const;
+	float GetPercentileRank(float Distance) const;
+	void WriteSidecar(const FString& CaptureFile) const;
+
+	EState State;
+	int32 WindowFrames;
+	int32 ArmedFrames;
+	int32 SteadyFrames;
+
+	// Window of samples, one array per statistic; all storage is reserved by Start(),
+	// so that sampling does not allocate:
+	TArray<float> Window [NumStats];
+	TArray<float> Scratch;
+	TArray<float> WindowDistances;
+	float Median [NumStats];
+	float Spread [NumStats];
+	float ArmDistance;
+
+	// Frame the capture was armed from:
+	float ArmedValues [NumStats];
+	float ArmedDistance;
+	float ArmedRank;
+
+	FRenderDocPluginFrameStatsSampler Sampler;
+
+	// Tunables, from the [RenderDoc] section of the game config:
+	int32 ConfigWindowFrames;
+	float Percentile;
+	int32 RequiredSteadyFrames;
+};
@@ -0,0 +1,84 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginMemoryGuard.h"
+
+#include "RenderDocPluginModule.h"
+
+static const uint64 MB = 1024 * 1024;
+
+FRenderDocPluginMemoryGuard::FRenderDocPluginMemoryGuard()
+	: bEnabled(true)
+	, HeadroomBytes(2048 * MB)
+{
+	if (!GConfig)
+		return;
+
+	int32 HeadroomMB = (int32)(HeadroomBytes / MB);
+	GConfig->GetBool(TEXT("RenderDoc"), TEXT("MemoryGuardEnabled"),    bEnabled,   GGameIni);
+	GConfig->GetInt (TEXT("RenderDoc"), TEXT("MemoryGuardHeadroomMB"), HeadroomMB, GGameIni);
+	HeadroomBytes = (uint64)FMath::Max(0, HeadroomMB) * MB;
+}
+
+FRenderDocPluginMemoryGuard::EVerdict FRenderDocPluginMemoryGuard::CheckBeforeCapture(bool bExpensiveOptions, FString& OutReason) const
+{
+	if (!bEnabled)
+		return(Allow);
+
+	// Rough worst-case estimates: referencing and saving every resource can cost
+	// as much as the process already uses; a regular capture only copies what the
+	// frame touches, which is bounded here by a quarter of it:
+	const FPlatformMemoryStats Stats = FPlatformMemory::GetStats();
+	const uint64 Available = Stats.AvailablePhysical;
+	const uint64 FullCost = Stats.UsedPhysical;
+	const uint64 MinimalCost = Stats.UsedPhysical / 4;
+
+	if (Available >= (bExpensiveOptions ? FullCost : MinimalCost) + HeadroomBytes)
+		return(Allow);
+
+	if (bExpensiveOptions && Available >= MinimalCost + HeadroomBytes)
+	{
+		OutReason = FString::Printf(TEXT("%llu MB available, ~%llu MB needed with RefAllResources/SaveAllInitials plus %llu MB headroom"),
+			Available / MB, FullCost / MB, HeadroomBytes / MB);
+		return(Downgrade);
+	}
+
+	OutReason = FString::Printf(TEXT("%llu MB available, ~%llu MB needed plus %llu MB headroom"), Available / MB, MinimalCost / MB, HeadroomBytes / MB);
+	return(Refuse);
+}
+
+bool FRenderDocPluginMemoryGuard::CheckDuringCapture(FString& OutReason) const
+{
+	if (!bEnabled)
+		return(true);
+
+	const uint64 Available = FPlatformMemory::GetStats().AvailablePhysical;
+	if (Available >= HeadroomBytes)
+		return(true);
+
+	OutReason = FString::Printf(TEXT("%llu MB available, below the %llu MB headroom"), Available / MB, HeadroomBytes / MB);
+	return(false);
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+/**
+* Keeps captures from exhausting physical memory. While RenderDoc is capturing it
+* holds on to the serialized API calls and to copies of resource contents, and
+* with "RefAllResources" or "SaveAllInitials" the copies cover every resource of
+* the device, which can double the memory of the process during EndFrameCapture.
+* The guard estimates the cost of a capture before it is armed and compares what
+* would be left against a configurable headroom:
+*
+*   [RenderDoc]
+*   MemoryGuardEnabled=True
+*   MemoryGuardHeadroomMB=2048
+*/
+class FRenderDocPluginMemoryGuard
+{
+public:
+	enum EVerdict
+	{
+		Allow,      // enough memory for the capture as configured
+		Downgrade,  // enough memory only without RefAllResources/SaveAllInitials
+		Refuse,     // not enough memory even for a minimal capture
+	};
+
+	FRenderDocPluginMemoryGuard();
+
+	/**
+	* Checks whether a capture can be armed. bExpensiveOptions tells whether
+	* RefAllResources or SaveAllInitials are enabled. Safe to call from any thread.
+	*/
+	EVerdict CheckBeforeCapture(bool bExpensiveOptions, FString& OutReason) const;
+
+	/**
+	* Checks whether a capture in progress can keep recording; false (and the
+	* reason) if the headroom has been eaten up. Safe to call from any thread.
+	*/
+	bool CheckDuringCapture(FString& OutReason) const;
+
+private:
+	bool bEnabled;
+	uint64 HeadroomBytes;
+};
@@ -25,62 +25,21 @@
 #include "RenderDocPluginPrivatePCH.h"
 #include "RenderDocPluginModule.h"
 
-#include "WindowsHWrapper.h"
+#include "RenderDocPluginNativeHandles.h"
 
 #include "Internationalization.h"
 #include "RendererInterface.h"
 
 #include "RenderDocPluginNotification.h"
 
+#include "Async.h"
+
 DEFINE_LOG_CATEGORY(RenderDocPlugin);
 
 #define LOCTEXT_NAMESPACE "RenderDocPlugin"
 
 
 
-/**
-* A dummy input device in order to be able to listen and respond to engine tick
-* events. The whole rendering activity between two engine ticks can be captured
-* including SceneCapture updates, Material Editor previews, Material Thumbnail
-* previews, Editor UI (Slate) widget rendering, etc.
-*/
-class FRenderDocPluginModule::FRenderDocDummyInputDevice : public IInputDevice
-{
-public:
-	//FRenderDocDummyInputDevice(const TSharedRef< FGenericApplicationMessageHandler >& MessageHandler) : ThePlugin(NULL) { }
-	FRenderDocDummyInputDevice() : ThePlugin(NULL) { }
-	virtual ~FRenderDocDummyInputDevice() { }
-
-	/** Tick the interface (used for controlling full engine frame captures). */
-	virtual void Tick(float DeltaTime) override
-	{
-		check(ThePlugin);
-		ThePlugin->Tick(DeltaTime);
-	}
-
-	/** The remaining interfaces are irrelevant for this dummy input device. */
-	virtual void SendControllerEvents() override { }
-	virtual void SetMessageHandler(const TSharedRef< FGenericApplicationMessageHandler >& InMessageHandler) override { }
-	virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override { return(false); }
-	virtual void SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value) override { }
-	virtual void SetChannelValues(int32 ControllerId, const FForceFeedbackValues &values) override { }
-
-private:
-	friend class FRenderDocPluginModule;
-	FRenderDocPluginModule* ThePlugin;
-
-};
-
-TSharedPtr< class IInputDevice > FRenderDocPluginModule::CreateInputDevice(const TSharedRef< FGenericApplicationMessageHandler >& InMessageHandler)
-{
-	UE_LOG(RenderDocPlugin, Log, TEXT("Creating dummy input device (for intercepting engine ticks)"));
-	FRenderDocDummyInputDevice* InputDev = new FRenderDocDummyInputDevice();
-	InputDev->ThePlugin = this;
-	return( MakeShareable(InputDev) );
-}
-
-
-
 void* GetRenderDocLibrary()
 {
 	void* RenderDocDLL (NULL);
@@ -88,7 +47,7 @@ void* GetRenderDocLibrary()
 	{
 		FString RenderdocPath;
 		GConfig->GetString(TEXT("RenderDoc"), TEXT("BinaryPath"), RenderdocPath, GGameIni);
-		FString PathToRenderDocDLL = FPaths::Combine(*RenderdocPath, *FString("renderdoc.dll"));
+		FString PathToRenderDocDLL = FPaths::Combine(*RenderdocPath, FRenderDocPluginLoader::GetLibraryName());
 		RenderDocDLL = FPlatformProcess::GetDllHandle(*PathToRenderDocDLL);
 	}
 	return(RenderDocDLL);
@@ -96,8 +55,79 @@ void* GetRenderDocLibrary()
 
 
 
+/**
+* Whether this process should use RenderDoc at all. Editor and Development builds
+* always do; Test builds only when explicitly asked to with -RenderDoc, so that a
+* regular Test run does not even load the RenderDoc library (which hooks the
+* graphics API and would skew the measurements); Shipping builds never do.
+*/
+static bool IsRenderDocRequested()
+{
+#if UE_BUILD_SHIPPING
+	return(false);
+#elif UE_BUILD_TEST
+	return(FParse::Param(FCommandLine::Get(), TEXT("RenderDoc")));
+#else
+	return(true);
+#endif
+}
+
+// The engine side of the capture scheduler:
+class FEngineCaptureClock : public IRenderDocCaptureClock
+{
+public:
+	virtual double GetSeconds() const override { return(FPlatformTime::Seconds()); }
+};
+
+class FEngineFrameSource : public IRenderDocFrameSource
+{
+public:
+	virtual uint64 GetEngineFrame() const override { return(GFrameCounter); }
+	virtual uint64 GetRenderFrame() const override { return(GFrameNumber); }
+};
+
+static FEngineCaptureClock EngineClock;
+static FEngineFrameSource EngineFrames;
+
 void FRenderDocPluginModule::StartupModule()
 {
+	RenderDocAPI = NULL;
+	CaptureMover = NULL;
+	Scheduler = new FRenderDocPluginCaptureScheduler(EngineClock, EngineFrames, *this);
+	bCaptureInFlight = false;
+	TriggerFilePollTime = 0.0;
+	ScopedCaptureDepth = 0;
+	bCapturing_RenderThread = false;
+	bScopedCaptureSkipped = false;
+	RangeCaptureBaseMemory = 0;
+	MapLoadCaptureFrames = 0;
+	bDowngradeNextCapture = false;
+	CaptureWindowHandle = NULL;
+#if WITH_EDITOR
+	EditorExtensions = NULL;
+#endif//WITH_EDITOR
+
+	if (!IsRenderDocRequested())
+		return;
+
+#if RENDERDOC_PLUGIN_SYNC
+	// Synchronized captures are joined with -RenderDocSync even by processes that
+	// will not capture (a dedicated server, without the RenderDoc library), so that
+	// they can coordinate the others and record their side of the synchronized frame:
+	if (FParse::Param(FCommandLine::Get(), TEXT("RenderDocSync")) && CaptureSync.Join())
+		CaptureSyncTickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRenderDocPluginModule::TickCaptureSync));
+
+	static FAutoConsoleCommand CCmdRenderDocCaptureSync = FAutoConsoleCommand(
+		TEXT("RenderDoc.CaptureSync"),
+		TEXT("Asks every process started with -RenderDocSync (this one included) to capture the same frame: RenderDoc.CaptureSync [lead seconds]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([this](const TArray<FString>& Args)
+		{
+			const bool bJoined = CaptureSync.IsJoined();
+			if (CaptureSync.Broadcast((Args.Num() > 0) ? FCString::Atof(*Args[0]) : -1.0f) && !bJoined)
+				CaptureSyncTickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRenderDocPluginModule::TickCaptureSync));
+		}));
+#endif//RENDERDOC_PLUGIN_SYNC
+
 	Loader.Initialize();
 
 	if (!Loader.RenderDocAPI)
@@ -119,9 +149,6 @@ void FRenderDocPluginModule::StartupModule()
 	RenderDocAPI = Loader.RenderDocAPI;
 	check(RenderDocAPI);
 
-	IModularFeatures::Get().RegisterModularFeature(GetModularFeatureName(), this);
-	TickNumber = 0;
-
 	// Setup RenderDoc settings
 	FString RenderDocCapturePath = FPaths::Combine(*FPaths::GameSavedDir(), *FString("RenderDocCaptures"));
 	if (!IFileManager::Get().DirectoryExists(*RenderDocCapturePath))
@@ -129,105 +156,533 @@ void FRenderDocPluginModule::StartupModule()
 		IFileManager::Get().MakeDirectory(*RenderDocCapturePath, true);
 	}
 
-	FString CapturePath = FPaths::Combine(*RenderDocCapturePath, *FDateTime::Now().ToString());
+	// Raw captures of previous sessions that made it into the capture store are
+	// no longer needed; they will be rebuilt from the store if ever reopened:
+	if (RenderDocSettings.bUseCaptureStore)
+	{
+		CaptureStore.PruneIngestedCaptures(RenderDocCapturePath);
+		CaptureStore.PruneCache();
+	}
+
+	// With a scratch directory configured, RenderDoc writes captures there and the
+	// capture mover migrates them to RenderDocCapturePath in the background:
+	FString CaptureDirectory = RenderDocCapturePath;
+	if (!RenderDocSettings.ScratchDirectory.IsEmpty())
+	{
+		CaptureDirectory = FPaths::ConvertRelativePathToFull(RenderDocSettings.ScratchDirectory);
+		if (IFileManager::Get().MakeDirectory(*CaptureDirectory, true))
+		{
+			CaptureMover = new FRenderDocPluginCaptureMover(CaptureDirectory, FPaths::ConvertRelativePathToFull(RenderDocCapturePath), &Events);
+			// Recovered captures go through the capture store like any other one:
+			TFunction<void(const FString&)> OnLeftoverMoved;
+			if (RenderDocSettings.bUseCaptureStore)
+			{
+				OnLeftoverMoved = [](const FString& FinalFile)
+				{
+					if (FinalFile.IsEmpty())
+						return;
+					RunAsyncTask(ENamedThreads::GameThread, [FinalFile]()
+					{
+						FRenderDocPluginModule* Plugin = static_cast<FRenderDocPluginModule*>(IRenderDocPlugin::GetIfLoaded());
+						if (Plugin)
+							Plugin->ArchiveCapture(FinalFile);
+					});
+				};
+			}
+			CaptureMover->EnqueueLeftovers(OnLeftoverMoved);
+		}
+		else
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("unable to create scratch directory '%s'; captures will be written to '%s'"), *CaptureDirectory, *RenderDocCapturePath);
+			CaptureDirectory = RenderDocCapturePath;
+		}
+	}
+
+	FString CapturePath = FPaths::Combine(*CaptureDirectory, *FDateTime::Now().ToString());
 	CapturePath = FPaths::ConvertRelativePathToFull(CapturePath);
 	FPaths::NormalizeDirectoryName(CapturePath);
 	
-	if (sizeof(TCHAR) == sizeof(char))
-		RenderDocAPI->SetLogFilePathTemplate((const char*)*CapturePath);
-	else
-		RenderDocAPI->SetLogFilePathTemplate(TCHAR_TO_ANSI(*CapturePath));
+	CapturePathTemplate = CapturePath;
+	SetCapturePathTemplate(CapturePathTemplate);
 
 	RenderDocAPI->SetFocusToggleKeys(NULL, 0);
 	RenderDocAPI->SetCaptureKeys(NULL, 0);
 
-	RenderDocAPI->SetCaptureOptionU32(eRENDERDOC_Option_CaptureCallstacks, RenderDocSettings.bCaptureCallStacks  ? 1 : 0);
-	RenderDocAPI->SetCaptureOptionU32(eRENDERDOC_Option_RefAllResources,   RenderDocSettings.bRefAllResources    ? 1 : 0);
-	RenderDocAPI->SetCaptureOptionU32(eRENDERDOC_Option_SaveAllInitials,   RenderDocSettings.bSaveAllInitials    ? 1 : 0);
+	// Apply the options right away: AllowVSync and APIValidation only affect
+	// devices created afterwards, and the RHI has not been initialized yet.
+	FMemory::Memset(AppliedCaptureOptions, 0xFF, sizeof(AppliedCaptureOptions));
+	ApplyCaptureOptions();
 
+	// The RenderDoc overlay would end up in the captures; game processes show the
+	// capture status through FRenderDocPluginHUD instead:
 	RenderDocAPI->MaskOverlayBits(eRENDERDOC_Overlay_None, eRENDERDOC_Overlay_None);
 
 #if WITH_EDITOR
 	EditorExtensions = new FRenderDocPluginEditorExtension (this, &RenderDocSettings);
+	FRenderDocPluginNotification::Get().Listen(Events);
 #endif//WITH_EDITOR
 
-#if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+	// IPC hook: with -RenderDocTrigger[=<file>], an external process requests a
+	// capture by creating the trigger file (polled twice a second; see Tick()):
+	FString TriggerFile;
+	if (FParse::Value(FCommandLine::Get(), TEXT("RenderDocTrigger="), TriggerFile))
+		CaptureTriggerFile = FPaths::ConvertRelativePathToFull(TriggerFile);
+	else if (FParse::Param(FCommandLine::Get(), TEXT("RenderDocTrigger")))
+		CaptureTriggerFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(*RenderDocCapturePath, TEXT("CaptureFrame.trigger")));
+	if (!CaptureTriggerFile.IsEmpty())
+		UE_LOG(RenderDocPlugin, Log, TEXT("capture trigger file: %s"), *CaptureTriggerFile);
+
+	Events.OnCaptureEvent().AddRaw(this, &FRenderDocPluginModule::OnCaptureEvent);
+	Events.OnCaptureEvent().AddRaw(&Flythrough, &FRenderDocPluginFlythrough::OnCaptureEvent);
+	Events.OnCaptureEvent().AddRaw(&ABCapture, &FRenderDocPluginABCapture::OnCaptureEvent);
+	Events.OnCaptureEvent().AddRaw(&MedianCapture, &FRenderDocPluginMedianCapture::OnCaptureEvent);
+#if RENDERDOC_PLUGIN_HUD
+	HUD.Listen(Events);
+#endif//RENDERDOC_PLUGIN_HUD
+
+	// Nightly flythrough: -RenderDocFlythrough[=<bookmarks file>] captures every
+	// bookmark of the map given on the command line, then exits:
+	FString BookmarksFile;
+	if (FParse::Value(FCommandLine::Get(), TEXT("RenderDocFlythrough="), BookmarksFile) || FParse::Param(FCommandLine::Get(), TEXT("RenderDocFlythrough")))
+	{
+		FString FlythroughPreset (TEXT("MinimalOverhead"));
+		FParse::Value(FCommandLine::Get(), TEXT("RenderDocFlythroughPreset="), FlythroughPreset);
+		StartFlythrough(BookmarksFile, FlythroughPreset, true);
+	}
+
+#if RENDERDOC_PLUGIN_SEQUENCER
+	// Movie renders: -RenderDocSequenceFrames=<sequence>@<frame>[+<sequence>@<frame>...]
+	FString SequenceFrames;
+	if (FParse::Value(FCommandLine::Get(), TEXT("RenderDocSequenceFrames="), SequenceFrames))
+		ScheduleSequenceFrames(SequenceFrames);
+#endif//RENDERDOC_PLUGIN_SEQUENCER
+
+	// Baselines: -RenderDocCaptureMedian[=<window frames>] captures a typical frame:
+	int32 MedianWindowFrames (0);
+	if (FParse::Value(FCommandLine::Get(), TEXT("RenderDocCaptureMedian="), MedianWindowFrames) || FParse::Param(FCommandLine::Get(), TEXT("RenderDocCaptureMedian")))
+		MedianCapture.Start(MedianWindowFrames);
+
+	// Startup stutter: -RenderDocCaptureFrame=<N> captures the engine tick that
+	// renders frame N (GFrameNumber); -RenderDocCaptureFirstFrames=<N> captures the
+	// first N frames after boot, and again after every map load with
+	// -RenderDocCaptureAfterMapLoad. Both are armed here, before any UI exists, and
+	// start at the first frame boundary once the RHI is up:
+	uint32 StartupCaptureFrame (0);
+	int32 StartupCaptureFrames (0);
+	FParse::Value(FCommandLine::Get(), TEXT("RenderDocCaptureFrame="), StartupCaptureFrame);
+	FParse::Value(FCommandLine::Get(), TEXT("RenderDocCaptureFirstFrames="), StartupCaptureFrames);
+	StartupCaptureFrames = FMath::Max(0, StartupCaptureFrames);
+	if (FParse::Param(FCommandLine::Get(), TEXT("RenderDocCaptureAfterMapLoad")))
+	{
+		MapLoadCaptureFrames = FMath::Max(1, StartupCaptureFrames);
+		PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMap.AddRaw(this, &FRenderDocPluginModule::OnPostLoadMap);
+	}
+	if (StartupCaptureFrame != 0)
+		UE_LOG(RenderDocPlugin, Log, TEXT("capture armed for frame %u"), StartupCaptureFrame);
+	if (StartupCaptureFrames != 0)
+		UE_LOG(RenderDocPlugin, Log, TEXT("capture armed for the first %d frames"), StartupCaptureFrames);
+	Scheduler->ArmStartupFrame(StartupCaptureFrame);
+	Scheduler->ArmFirstFrames(StartupCaptureFrames);
+
+	BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FRenderDocPluginModule::OnBeginFrame);
+	EndFrameHandle   = FCoreDelegates::OnEndFrame.AddRaw(this, &FRenderDocPluginModule::OnEndFrame);
+
+#if !UE_BUILD_SHIPPING
 	static FAutoConsoleCommand CCmdRenderDocCaptureFrame = FAutoConsoleCommand(
 		TEXT("RenderDoc.CaptureFrame"),
 		TEXT("Captures the rendering commands of the next frame and launches RenderDoc"),
 		FConsoleCommandDelegate::CreateRaw(this, &FRenderDocPluginModule::CaptureFrame));
+
+	static FAutoConsoleCommand CCmdRenderDocBeginRange = FAutoConsoleCommand(
+		TEXT("RenderDoc.BeginRange"),
+		TEXT("Starts capturing every frame until RenderDoc.EndRange (or until the RangeCaptureMaxFrames/RangeCaptureMaxMB caps are reached)"),
+		FConsoleCommandDelegate::CreateRaw(this, &FRenderDocPluginModule::BeginRangeCapture));
+
+	static FAutoConsoleCommand CCmdRenderDocEndRange = FAutoConsoleCommand(
+		TEXT("RenderDoc.EndRange"),
+		TEXT("Ends the range capture started by RenderDoc.BeginRange and launches RenderDoc"),
+		FConsoleCommandDelegate::CreateRaw(this, &FRenderDocPluginModule::EndRangeCapture));
+
+	static FAutoConsoleCommand CCmdRenderDocToggleRange = FAutoConsoleCommand(
+		TEXT("RenderDoc.ToggleRange"),
+		TEXT("Starts a range capture, or ends the one in progress"),
+		FConsoleCommandDelegate::CreateLambda([this]()
+		{
+			if (Scheduler->IsRangeActive())
+				EndRangeCapture();
+			else
+				BeginRangeCapture();
+		}));
+
+#if WITH_EDITOR
+	static FAutoConsoleCommand CCmdRenderDocShaderDebugInfo = FAutoConsoleCommand(
+		TEXT("RenderDoc.ShaderDebugInfo"),
+		TEXT("Enables (1) or disables (0) recompiling the materials of captured frames with shader debug info"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([this](const TArray<FString>& Args)
+		{
+			ShaderDebugInfo.SetEnabled((Args.Num() > 0) ? FCString::Atoi(*Args[0]) != 0 : !ShaderDebugInfo.IsEnabled());
+			UE_LOG(RenderDocPlugin, Log, TEXT("shader debug info recompilation %s"), ShaderDebugInfo.IsEnabled() ? TEXT("enabled") : TEXT("disabled"));
+		}));
+#endif//WITH_EDITOR
+
+	static FAutoConsoleCommand CCmdRenderDocFlythrough = FAutoConsoleCommand(
+		TEXT("RenderDoc.Flythrough"),
+		TEXT("Captures a frame at every bookmark of the current map (or of a bookmarks file) and writes a manifest: RenderDoc.Flythrough [bookmarks file] [preset]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([this](const TArray<FString>& Args)
+		{
+			StartFlythrough((Args.Num() > 0) ? Args[0] : FString(), (Args.Num() > 1) ? Args[1] : FString(TEXT("MinimalOverhead")), false);
+		}));
+
+	static FAutoConsoleCommand CCmdRenderDocCaptureWorld = FAutoConsoleCommand(
+		TEXT("RenderDoc.CaptureWorld"),
+		TEXT("Captures the next draw of a single Play-In-Editor instance: RenderDoc.CaptureWorld <PIE instance>; without arguments, lists the instances"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FRenderDocPluginModule::CaptureWorld));
+
+#if RENDERDOC_PLUGIN_SEQUENCER
+	static FAutoConsoleCommand CCmdRenderDocCaptureSequenceFrame = FAutoConsoleCommand(
+		TEXT("RenderDoc.CaptureSequenceFrame"),
+		TEXT("Captures a frame of a level sequence when it gets evaluated: RenderDoc.CaptureSequenceFrame <sequence> <frame> [frame rate]; without arguments, lists the scheduled frames"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([this](const TArray<FString>& Args)
+		{
+			if (Args.Num() < 2)
+				SequenceCapture.ListScheduledFrames();
+			else
+				SequenceCapture.Schedule(Args[0], FCString::Atoi(*Args[1]), (Args.Num() > 2) ? FCString::Atof(*Args[2]) : 0.0f);
+		}));
+#endif//RENDERDOC_PLUGIN_SEQUENCER
+
+	static FAutoConsoleCommand CCmdRenderDocCaptureAB = FAutoConsoleCommand(
+		TEXT("RenderDoc.CaptureAB"),
+		TEXT("Pauses the game and captures the same frame under two configurations, then writes a paired manifest: RenderDoc.CaptureAB <cvar> <A value> <B value> [<cvar> <A value> <B value>...]"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FRenderDocPluginModule::StartABCapture));
+
+	static FAutoConsoleCommand CCmdRenderDocCaptureMedian = FAutoConsoleCommand(
+		TEXT("RenderDoc.CaptureMedian"),
+		TEXT("Samples a window of frames, then captures a frame close to the window median (frame time, draw calls, thread times): RenderDoc.CaptureMedian [window frames]"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FRenderDocPluginModule::StartMedianCapture));
+
+	static FAutoConsoleCommand CCmdRenderDocOpenCapture = FAutoConsoleCommand(
+		TEXT("RenderDoc.OpenCapture"),
+		TEXT("Rebuilds a capture from the capture store (if necessary) and opens it in RenderDoc: RenderDoc.OpenCapture <capture name>"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FRenderDocPluginModule::OpenStoredCapture));
+
+	static FAutoConsoleCommand CCmdRenderDocPreset = FAutoConsoleCommand(
+		TEXT("RenderDoc.Preset"),
+		TEXT("Selects a capture option preset: RenderDoc.Preset <MinimalOverhead|CallstacksOnDraws|FullFidelity>; without arguments, lists the presets and their measured costs"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FRenderDocPluginModule::SelectPreset));
+
+	static FAutoConsoleCommand CCmdRenderDocStatTriggers = FAutoConsoleCommand(
+		TEXT("RenderDoc.StatTriggers"),
+		TEXT("Enables (1) or disables (0) automatic captures on render stat thresholds (see the StatTrigger rules of the [RenderDoc] config section)"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([this](const TArray<FString>& Args)
+		{
+			StatTriggers.SetEnabled((Args.Num() > 0) ? FCString::Atoi(*Args[0]) != 0 : !StatTriggers.IsEnabled());
+			UE_LOG(RenderDocPlugin, Log, TEXT("stat triggers %s"), StatTriggers.IsEnabled() ? TEXT("enabled") : TEXT("disabled"));
+		}));
+
+#if RENDERDOC_PLUGIN_HUD
+	static FAutoConsoleCommand CCmdRenderDocHUD = FAutoConsoleCommand(
+		TEXT("RenderDoc.HUD"),
+		TEXT("Shows (1) or hides (0) the capture status over the game viewport (see the ShowHUD setting of the [RenderDoc] config section)"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([this](const TArray<FString>& Args)
+		{
+			HUD.SetEnabled((Args.Num() > 0) ? FCString::Atoi(*Args[0]) != 0 : !HUD.IsEnabled());
+		}));
+#endif//RENDERDOC_PLUGIN_HUD
 #endif
 
 	UE_LOG(RenderDocPlugin, Log, TEXT("RenderDoc plugin is ready!"));
 }
 
+/**
+* Runs a function as part of the RHI command stream of the immediate command list.
+* With a dedicated RHI thread (and parallel command list translation), the native
+* API calls of a frame are issued by the RHI thread well after the render thread
+* has moved on, so RenderDoc calls made from the render thread itself would not
+* line up with the frame; as RHI commands, they run exactly between the native
+* calls of the commands enqueued before and after them.
+*/
+struct FRHICommandRenderDoc : public FRHICommand<FRHICommandRenderDoc>
+{
+	TFunction<void()> Work;
+
+	FORCEINLINE_DEBUGGABLE FRHICommandRenderDoc(TFunction<void()>&& InWork)
+		: Work(MoveTemp(InWork))
+	{ }
+
+	void Execute(FRHICommandListBase& CmdList)
+	{
+		Work();
+	}
+};
+
+static void EnqueueRenderDocRHICommand(TFunction<void()>&& Work)
+{
+	check(IsInRenderingThread());
+	FRHICommandListImmediate& RHICmdList = FRHICommandListExecutor::GetImmediateCommandList();
+	if (RHICmdList.Bypass())
+	{
+		Work();
+		return;
+	}
+	new (RHICmdList.AllocCommand<FRHICommandRenderDoc>()) FRHICommandRenderDoc(MoveTemp(Work));
+}
+
 class FRenderDocPluginModule::FrameCapturer
 {
 public:
-	static void BeginCapture(HWND WindowHandle, FRenderDocPluginLoader::RENDERDOC_API_CONTEXT* RenderDocAPI, FRenderDocPluginModule* Plugin)
+	// Both are called on the render thread; RenderDoc itself is called from the RHI
+	// command stream (see FRHICommandRenderDoc). PathTemplate, if not empty, names
+	// this capture after its Label, and the default template is restored once it has
+	// been written.
+	static void BeginCapture(RENDERDOC_WindowHandle WindowHandle, FRenderDocPluginLoader::RENDERDOC_API_CONTEXT* RenderDocAPI, FRenderDocPluginModule* Plugin, const FString& PathTemplate = FString())
 	{
 		Plugin->UE4_OverrideDrawEventsFlag();
-		RENDERDOC_DevicePointer Device = GDynamicRHI->RHIGetNativeDevice();
-		RenderDocAPI->StartFrameCapture(Device, WindowHandle);
+		Plugin->bCapturing_RenderThread = true;
+		const int64 RenderFrame = GFrameNumberRenderThread;
+		EnqueueRenderDocRHICommand([WindowHandle, RenderDocAPI, Plugin, PathTemplate, RenderFrame]()
+		{
+			if (!PathTemplate.IsEmpty())
+				Plugin->SetCapturePathTemplate(PathTemplate);
+			RENDERDOC_DevicePointer Device = FRenderDocPluginNativeHandles::GetDevicePointer();
+			Plugin->CaptureStartTime = FPlatformTime::Seconds();
+			RenderDocAPI->StartFrameCapture(Device, WindowHandle);
+			Plugin->CaptureBeginSeconds = FPlatformTime::Seconds() - Plugin->CaptureStartTime;
+			Plugin->CaptureFirstRenderFrame = RenderFrame;
+			Plugin->Events.Post(FRenderDocPluginEvent(ERenderDocCaptureStage::Capturing));
+		});
 	}
-	static void EndCapture(HWND WindowHandle, FRenderDocPluginLoader::RENDERDOC_API_CONTEXT* RenderDocAPI, FRenderDocPluginModule* Plugin)
+	static void EndCapture(RENDERDOC_WindowHandle WindowHandle, FRenderDocPluginLoader::RENDERDOC_API_CONTEXT* RenderDocAPI, FRenderDocPluginModule* Plugin, const FString& Label = FString())
 	{
-		RENDERDOC_DevicePointer Device = GDynamicRHI->RHIGetNativeDevice();
-		RenderDocAPI->EndFrameCapture(Device, WindowHandle);
-		Plugin->UE4_RestoreDrawEventsFlag();
-
-		Plugin->RunAsyncTask(ENamedThreads::GameThread, [Plugin]()
+		const int64 RenderFrame = GFrameNumberRenderThread;
+		EnqueueRenderDocRHICommand([WindowHandle, RenderDocAPI, Plugin, Label, RenderFrame]()
 		{
-			Plugin->StartRenderDoc(FPaths::Combine(*FPaths::GameSavedDir(), *FString("RenderDocCaptures")));
+			RENDERDOC_DevicePointer Device = FRenderDocPluginNativeHandles::GetDevicePointer();
+			Plugin->Events.Post(FRenderDocPluginEvent(ERenderDocCaptureStage::Writing));
+			const double EndStartTime = FPlatformTime::Seconds();
+			RenderDocAPI->EndFrameCapture(Device, WindowHandle);
+			const double EndSeconds = FPlatformTime::Seconds() - EndStartTime;
+			const double CaptureSeconds = FPlatformTime::Seconds() - Plugin->CaptureStartTime;
+			if (!Label.IsEmpty())
+				Plugin->SetCapturePathTemplate(Plugin->CapturePathTemplate);
+
+			const double BeginSeconds = Plugin->CaptureBeginSeconds;
+			const int64 FirstRenderFrame = Plugin->CaptureFirstRenderFrame;
+			Plugin->RunAsyncTask(ENamedThreads::GameThread, [Plugin, CaptureSeconds, BeginSeconds, EndSeconds, FirstRenderFrame, RenderFrame, Label]()
+			{
+				FRenderDocCaptureInfo& Info = Plugin->CurrentCapture;
+				Info.FirstRenderFrame = FirstRenderFrame;
+				Info.LastRenderFrame = RenderFrame;
+				Info.BeginSeconds = BeginSeconds;
+				Info.EndSeconds = EndSeconds;
+				Info.CaptureSeconds = CaptureSeconds;
+				Plugin->StartRenderDoc(FPaths::Combine(*FPaths::GameSavedDir(), *FString("RenderDocCaptures")), CaptureSeconds, Label);
+			});
 		});
+		Plugin->bCapturing_RenderThread = false;
+		Plugin->UE4_RestoreDrawEventsFlag();
 	}
 };
 
-void FRenderDocPluginModule::BeginCapture()
+void FRenderDocPluginModule::BeginCapture(UGameViewportClient* ViewportClient)
 {
 	UE_LOG(RenderDocPlugin, Log, TEXT("Capture frame and launch renderdoc!"));
+	CaptureLabel = NextCaptureLabel;
+	NextCaptureLabel.Empty();
+	FRenderDocPluginEvent Requested (ERenderDocCaptureStage::Requested);
+	Requested.Label = CaptureLabel;
+	Events.Post(Requested);
+
+	ApplyCaptureOptions();
+
 #if WITH_EDITOR
-	FRenderDocPluginNotification::Get().ShowNotification(NSLOCTEXT("LaunchRenderDocGUI", "LaunchRenderDocGUIShow", "Capturing frame"));
-#else
-	// TODO: if there is no editor, notify via game viewport text
+	// The frame about to be captured draws (nearly) the same primitives as the last one:
+	ShaderDebugInfo.CollectRenderedMaterials();
 #endif//WITH_EDITOR
 
-	// TODO: maybe move these SetOptions() to FRenderDocPluginSettings...
-	pRENDERDOC_SetCaptureOptionU32 SetOptions = Loader.RenderDocAPI->SetCaptureOptionU32;
-	int ok = SetOptions(eRENDERDOC_Option_CaptureCallstacks, RenderDocSettings.bCaptureCallStacks ? 1 : 0); check(ok);
-	    ok = SetOptions(eRENDERDOC_Option_RefAllResources,   RenderDocSettings.bRefAllResources   ? 1 : 0); check(ok);
-	    ok = SetOptions(eRENDERDOC_Option_SaveAllInitials,   RenderDocSettings.bSaveAllInitials   ? 1 : 0); check(ok);
-
-	HWND WindowHandle = GetActiveWindow();
+	CaptureWindowHandle = ViewportClient ? FRenderDocPluginNativeHandles::GetViewportWindowHandle(ViewportClient) : FRenderDocPluginNativeHandles::GetWindowHandle();
+	RENDERDOC_WindowHandle WindowHandle = CaptureWindowHandle;
+	const FString PathTemplate = GetLabeledPathTemplate(CaptureLabel);
 
 	typedef FRenderDocPluginLoader::RENDERDOC_API_CONTEXT RENDERDOC_API_CONTEXT;
-	ENQUEUE_UNIQUE_RENDER_COMMAND_THREEPARAMETER(
+	ENQUEUE_UNIQUE_RENDER_COMMAND_FOURPARAMETER(
 		StartRenderDocCapture,
-		HWND, WindowHandle, WindowHandle,
+		RENDERDOC_WindowHandle, WindowHandle, WindowHandle,
 		RENDERDOC_API_CONTEXT*, RenderDocAPI, RenderDocAPI,
 		FRenderDocPluginModule*, Plugin, this,
+		FString, PathTemplate, PathTemplate,
 		{
-			FrameCapturer::BeginCapture(WindowHandle, RenderDocAPI, Plugin);
+			FrameCapturer::BeginCapture(WindowHandle, RenderDocAPI, Plugin, PathTemplate);
 		});
 }
 
 void FRenderDocPluginModule::EndCapture()
 {
-	HWND WindowHandle = GetActiveWindow();
+	RENDERDOC_WindowHandle WindowHandle = CaptureWindowHandle;
+	CaptureWindowHandle = NULL;
+	const FString Label = CaptureLabel;
+	CaptureLabel.Empty();
 
 	typedef FRenderDocPluginLoader::RENDERDOC_API_CONTEXT RENDERDOC_API_CONTEXT;
-	ENQUEUE_UNIQUE_RENDER_COMMAND_THREEPARAMETER(
+	ENQUEUE_UNIQUE_RENDER_COMMAND_FOURPARAMETER(
 		EndRenderDocCapture,
-		HWND, WindowHandle, WindowHandle,
+		RENDERDOC_WindowHandle, WindowHandle, WindowHandle,
 		RENDERDOC_API_CONTEXT*, RenderDocAPI, RenderDocAPI,
 		FRenderDocPluginModule*, Plugin, this,
+		FString, Label, Label,
 		{
-			FrameCapturer::EndCapture(WindowHandle, RenderDocAPI, Plugin); return;
+			FrameCapturer::EndCapture(WindowHandle, RenderDocAPI, Plugin, Label); return;
 		});
 }
 
+void FRenderDocPluginModule::SetCapturePathTemplate(const FString& PathTemplate)
+{
+	if (sizeof(TCHAR) == sizeof(char))
+		RenderDocAPI->SetLogFilePathTemplate((const char*)*PathTemplate);
+	else
+		RenderDocAPI->SetLogFilePathTemplate(TCHAR_TO_ANSI(*PathTemplate));
+}
+
+bool FRenderDocPluginModule::IsCaptureAvailable() const
+{
+	return(RenderDocAPI != NULL);
+}
+
+void FRenderDocPluginModule::BeginScopedCapture(const TCHAR* Label)
+{
+	if (!RenderDocAPI)
+		return;
+
+	const FString LabelString = (Label && *Label) ? FString(Label) : FString();
+	if (IsInRenderingThread())
+	{
+		BeginScopedCapture_RenderThread(LabelString);
+		return;
+	}
+
+	check(IsInGameThread());
+	// Refusals are left to the render thread, which checks again right before
+	// capturing and reports them; only the downgrade of the capture options has to
+	// be decided here, while they can still be changed:
+	FString MemoryReason;
+	const bool bExpensiveOptions = (RenderDocSettings.bRefAllResources || RenderDocSettings.bSaveAllInitials);
+	if (MemoryGuard.CheckBeforeCapture(bExpensiveOptions, MemoryReason) == FRenderDocPluginMemoryGuard::Downgrade)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("memory guard: capturing without RefAllResources/SaveAllInitials (%s)"), *MemoryReason);
+		bDowngradeNextCapture = true;
+	}
+	ApplyCaptureOptions();
+	ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+		BeginRenderDocScopedCapture,
+		FRenderDocPluginModule*, Plugin, this,
+		FString, Label, LabelString,
+		{
+			Plugin->BeginScopedCapture_RenderThread(Label);
+		});
+}
+
+void FRenderDocPluginModule::EndScopedCapture()
+{
+	if (!RenderDocAPI)
+		return;
+
+	if (IsInRenderingThread())
+	{
+		EndScopedCapture_RenderThread();
+		return;
+	}
+
+	check(IsInGameThread());
+	ENQUEUE_UNIQUE_RENDER_COMMAND_ONEPARAMETER(
+		EndRenderDocScopedCapture,
+		FRenderDocPluginModule*, Plugin, this,
+		{
+			Plugin->EndScopedCapture_RenderThread();
+		});
+}
+
+FString FRenderDocPluginModule::GetLabeledPathTemplate(const FString& Label) const
+{
+	if (Label.IsEmpty())
+		return(FString());
+
+	FString SafeLabel = Label;
+	for (const TCHAR* Invalid = TEXT("\\/:*?\"<>| "); *Invalid; ++Invalid)
+		SafeLabel.ReplaceInline(*FString::Chr(*Invalid), TEXT("_"));
+	return(FPaths::Combine(*FPaths::GetPath(CapturePathTemplate), *(SafeLabel + TEXT("_") + FDateTime::Now().ToString())));
+}
+
+void FRenderDocPluginModule::BeginScopedCapture_RenderThread(const FString& Label)
+{
+	if (ScopedCaptureDepth++ > 0)
+		return;
+
+	// A frame capture (or another module's region) is already being recorded; this
+	// region is part of it anyway:
+	bScopedCaptureSkipped = bCapturing_RenderThread;
+	if (bScopedCaptureSkipped)
+	{
+		UE_LOG(RenderDocPlugin, Log, TEXT("scoped capture '%s' ignored: a capture is already in progress"), *Label);
+		return;
+	}
+
+	// Capture options can not be changed from here, so a capture that would need
+	// cheaper options is refused as well:
+	FString MemoryReason;
+	const bool bExpensiveOptions = (AppliedCaptureOptions[eRENDERDOC_Option_RefAllResources] == 1 || AppliedCaptureOptions[eRENDERDOC_Option_SaveAllInitials] == 1);
+	bScopedCaptureSkipped = (MemoryGuard.CheckBeforeCapture(bExpensiveOptions, MemoryReason) != FRenderDocPluginMemoryGuard::Allow);
+	if (bScopedCaptureSkipped)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("scoped capture '%s' refused by the memory guard: %s"), *Label, *MemoryReason);
+		FRenderDocPluginEvent Requested (ERenderDocCaptureStage::Requested);
+		Requested.Label = Label;
+		FRenderDocPluginEvent Refused (ERenderDocCaptureStage::Failed);
+		Refused.Label = Label;
+		Refused.Message = FString::Printf(TEXT("refused by the memory guard: %s"), *MemoryReason);
+		Events.Post(Requested);
+		Events.Post(Refused);
+		return;
+	}
+
+	UE_LOG(RenderDocPlugin, Log, TEXT("Capture region '%s' and launch renderdoc!"), *Label);
+
+	// Regions are usually recorded from code that is not tied to a window (scene
+	// captures, compute jobs), so any window of the device is accepted:
+	FRenderDocPluginEvent Requested (ERenderDocCaptureStage::Requested);
+	Requested.Label = Label;
+	Events.Post(Requested);
+	ScopedCaptureLabel = Label;
+	FrameCapturer::BeginCapture(NULL, RenderDocAPI, this, GetLabeledPathTemplate(Label));
+}
+
+void FRenderDocPluginModule::EndScopedCapture_RenderThread()
+{
+	if (ScopedCaptureDepth <= 0)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("EndScopedCapture called without a matching BeginScopedCapture"));
+		return;
+	}
+	if (--ScopedCaptureDepth > 0)
+		return;
+
+	if (bScopedCaptureSkipped)
+	{
+		bScopedCaptureSkipped = false;
+		return;
+	}
+
+	FrameCapturer::EndCapture(NULL, RenderDocAPI, this, ScopedCaptureLabel);
+	ScopedCaptureLabel.Empty();
+}
+
 void FRenderDocPluginModule::CaptureFrame()
 {
+	// Every frame is already being recorded:
+	if (Scheduler->IsRangeActive())
+		return;
+
+	// Entire frame captures go through the memory budget when armed, viewport
+	// captures in CaptureCurrentViewport (once either way):
 	if (RenderDocSettings.bCaptureAllActivity)
 		CaptureEntireFrame();
 	else
@@ -236,11 +691,38 @@ void FRenderDocPluginModule::CaptureFrame()
 
 void FRenderDocPluginModule::CaptureCurrentViewport()
 {
+	check(GEngine);
+
+	// Offscreen renders have no focused viewport to redraw; whatever the frame
+	// renders (render targets, compute work) is captured instead:
+	if (FRenderDocPluginNativeHandles::IsWindowless())
+	{
+		CaptureEntireFrame();
+		return;
+	}
+
+	if (RenderDocSettings.bDeferredViewportCapture)
+	{
+		UGameViewportClient* GameViewport = GEngine->GameViewport;
+		if (GameViewport && GameViewport->Viewport && GameViewport->Viewport->HasFocus())
+		{
+			if (CheckMemoryBudget())
+				CaptureNextViewportDraw(GameViewport);
+		}
+		else
+			// Editor viewport clients expose no draw notifications; the closest natural
+			// (non-forced) render of the active editor viewport is the next engine frame:
+			CaptureEntireFrame();
+		return;
+	}
+
+	if (!CheckMemoryBudget())
+		return;
+
 	BeginCapture();
 
 	// infer the intended viewport to intercept/capture:
 	FViewport* Viewport (NULL);
-	check(GEngine);
 	if (!Viewport && GEngine->GameViewport)
 	{
 		check(GEngine->GameViewport->Viewport);
@@ -263,70 +745,645 @@ void FRenderDocPluginModule::CaptureCurrentViewport()
 	EndCapture();
 }
 
-void FRenderDocPluginModule::CaptureEntireFrame()
+void FRenderDocPluginModule::CaptureNextViewportDraw(UGameViewportClient* ViewportClient)
 {
-	// Are we already in thw workings of capturing an entire engine frame?
-	if (TickNumber != 0)
+	// Is a viewport capture already pending?
+	if (ViewportCaptureClient.IsValid())
 		return;
 
-	// Begin tracking the global tick counter so that the Tick() method below can
-	// identify the beginning and end of a complete engine update cycle:
-	TickNumber = GFrameCounter;
-	// NOTE: GFrameCounter counts engine ticks, while GFrameNumber counts render
-	// frames. Multiple frames might get rendered in a single engine update tick.
-	// All active windows are updated, in a round-robin fashion, within a single
-	// engine tick. This includes thumbnail images for material preview, material
-	// editor previews, cascade/persona previes, etc.
+	// Rather than forcing an extra (synchronous) redraw, bracket the next regular
+	// draw of the viewport: the render commands enqueued between OnBeginDraw and
+	// OnEndDraw are exactly the ones rendering the viewport, so the Begin/End
+	// capture commands enqueued from these delegates enclose them on the render
+	// thread, and the captured frame is the one the game renders anyway.
+	ViewportCaptureClient = ViewportClient;
+	ViewportBeginDrawHandle = ViewportClient->OnBeginDraw().AddRaw(this, &FRenderDocPluginModule::OnViewportBeginDraw);
+	ViewportEndDrawHandle   = ViewportClient->OnEndDraw().AddRaw(this, &FRenderDocPluginModule::OnViewportEndDraw);
+	bViewportCaptureStarted = false;
 }
 
-void FRenderDocPluginModule::Tick(float DeltaTime)
+FString FRenderDocPluginModule::DescribeWorld(const FWorldContext& Context)
+{
+	const UWorld* World = Context.World();
+	const TCHAR* Role = TEXT("Standalone");
+	switch (World ? World->GetNetMode() : NM_Standalone)
+	{
+	case NM_DedicatedServer : Role = TEXT("Dedicated Server"); break;
+	case NM_ListenServer :    Role = TEXT("Listen Server"); break;
+	case NM_Client :          Role = TEXT("Client"); break;
+	default : break;
+	}
+	return(FString::Printf(TEXT("PIE %d: %s (%s)"), Context.PIEInstance, Role, World ? *World->GetMapName() : TEXT("no world")));
+}
+
+void FRenderDocPluginModule::CaptureWorld(int32 PIEInstance)
+{
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if (Context.WorldType != EWorldType::PIE || Context.PIEInstance != PIEInstance)
+			continue;
+
+		// Each PIE instance renders through its own game viewport, so bracketing the
+		// draw of that viewport leaves the other instances out of the capture:
+		if (!Context.GameViewport)
+		{
+			UE_LOG(RenderDocPlugin, Warning, TEXT("%s has no viewport to capture"), *DescribeWorld(Context));
+			return;
+		}
+		if (Scheduler->IsRangeActive() || !CheckMemoryBudget())
+			return;
+
+		UE_LOG(RenderDocPlugin, Log, TEXT("capturing the next draw of %s"), *DescribeWorld(Context));
+		CaptureNextViewportDraw(Context.GameViewport);
+		return;
+	}
+
+	UE_LOG(RenderDocPlugin, Warning, TEXT("no Play-In-Editor instance %d"), PIEInstance);
+}
+
+void FRenderDocPluginModule::CaptureWorld(const TArray<FString>& Args)
 {
-	if (TickNumber == 0)
+	if (Args.Num() > 0)
+	{
+		CaptureWorld(FCString::Atoi(*Args[0]));
 		return;
+	}
+
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		if (Context.WorldType == EWorldType::PIE)
+			UE_LOG(RenderDocPlugin, Display, TEXT("%s%s"), *DescribeWorld(Context), Context.GameViewport ? TEXT("") : TEXT(" [no viewport]"));
+}
+
+void FRenderDocPluginModule::OnViewportBeginDraw()
+{
+	// The window of the viewport being drawn, rather than whichever one has the
+	// focus (another PIE instance, the editor):
+	BeginCapture(ViewportCaptureClient.Get());
+	bViewportCaptureStarted = true;
+}
+
+void FRenderDocPluginModule::OnViewportEndDraw()
+{
+	if (!bViewportCaptureStarted)
+		return;
+
+	EndCapture();
+	bViewportCaptureStarted = false;
+
+	if (UGameViewportClient* ViewportClient = ViewportCaptureClient.Get())
+	{
+		ViewportClient->OnBeginDraw().Remove(ViewportBeginDrawHandle);
+		ViewportClient->OnEndDraw().Remove(ViewportEndDrawHandle);
+	}
+	ViewportCaptureClient.Reset();
+}
+
+bool FRenderDocPluginModule::CaptureEntireFrame(const FString& Label)
+{
+	// Arm the capture; the scheduler brackets the next complete engine update
+	// cycle, from OnBeginFrame() to OnEndFrame() below. Nothing happens if a frame
+	// or range capture is already under way. The label is in place before the
+	// request, as admitting it may already report a refusal under that label:
+	if (!Scheduler->IsIdle())
+		return(false);
+	NextCaptureLabel = Label;
+	if (Scheduler->RequestFrame())
+		return(true);
+	NextCaptureLabel.Empty();
+	return(false);
+}
+
+void FRenderDocPluginModule::OnBeginFrame()
+{
+	Tick(FApp::GetDeltaTime());
+
+	// The start command is enqueued before any rendering command of this engine
+	// tick, so the render thread starts capturing right at the frame boundary:
+	Scheduler->OnBeginFrame(ViewportCaptureClient.IsValid());
+
+#if RENDERDOC_PLUGIN_HUD
+	HUD.OnFrame(FApp::GetDeltaTime(), !Scheduler->IsIdle() || ViewportCaptureClient.IsValid(), Scheduler->GetRangeFrames(), Scheduler->GetRangeMaxFrames());
+#endif//RENDERDOC_PLUGIN_HUD
+}
 
-	const uint32 TickDiff = GFrameCounter - TickNumber;
-	const uint32 MaxCount = 2;
+void FRenderDocPluginModule::OnEndFrame()
+{
+	// ...and the end command after the last one, including the RHI end of frame:
+	Scheduler->OnEndFrame();
+}
 
-	check(TickDiff <= MaxCount);
+bool FRenderDocPluginModule::AdmitScheduledCapture(const FRenderDocCaptureRequest& Request)
+{
+	if (CheckMemoryBudget(NextCaptureLabel))
+		return(true);
+	NextCaptureLabel.Empty();
+	return(false);
+}
 
-	if (TickDiff == 1)
-		BeginCapture();
+void FRenderDocPluginModule::BeginScheduledCapture(const FRenderDocCaptureRequest& Request)
+{
+	switch (Request.Kind)
+	{
+	case FRenderDocCaptureRequest::StartupFrame :
+		if (Request.RenderFrame > Request.TargetRenderFrame)
+			UE_LOG(RenderDocPlugin, Warning, TEXT("frame %llu was rendered before the plugin could capture it; capturing frame %llu instead"), Request.TargetRenderFrame, Request.RenderFrame);
+		NextCaptureLabel = FString::Printf(TEXT("Frame%llu"), Request.RenderFrame);
+		break;
+
+	case FRenderDocCaptureRequest::FirstFrames :
+		NextCaptureLabel = FString::Printf(TEXT("First%uFrames"), Request.MaxFrames);
+		RangeCaptureBaseMemory = FPlatformMemory::GetStats().UsedPhysical;
+		break;
+
+	case FRenderDocCaptureRequest::Range :
+		UE_LOG(RenderDocPlugin, Log, TEXT("range capture started (at most %u frames, %d MB)"), Request.MaxFrames, RenderDocSettings.RangeCaptureMaxMB);
+		RangeCaptureBaseMemory = FPlatformMemory::GetStats().UsedPhysical;
+		break;
+
+	default :
+		break;
+	}
 
-	if (TickDiff == MaxCount)
-		EndCapture(),
-		TickNumber = 0;
+	BeginCapture();
 }
 
-void FRenderDocPluginModule::StartRenderDoc(FString FrameCaptureBaseDirectory)
+void FRenderDocPluginModule::EndScheduledCapture(const FRenderDocCaptureRequest& Request, uint64 Frames, double Seconds)
 {
+	if (Request.Kind == FRenderDocCaptureRequest::Range && Frames >= Request.MaxFrames)
+		UE_LOG(RenderDocPlugin, Warning, TEXT("range capture reached its frame cap (RangeCaptureMaxFrames=%u); ending it"), Request.MaxFrames);
+	if (Request.Kind == FRenderDocCaptureRequest::Range || Request.Kind == FRenderDocCaptureRequest::FirstFrames)
+		UE_LOG(RenderDocPlugin, Log, TEXT("range capture ended after %llu frames (%.1f seconds)"), Frames, Seconds);
+
+	EndCapture();
+}
+
+void FRenderDocPluginModule::Tick(float DeltaTime)
+{
+	if (!RenderDocAPI)
+		return;
+
+#if RENDERDOC_PLUGIN_SYNC
+	// Synchronized captures are due at a given time, whatever else is going on:
+	FString SyncLabel;
+	if (CaptureSync.Tick(SyncLabel) && !CaptureEntireFrame(SyncLabel))
+		UE_LOG(RenderDocPlugin, Warning, TEXT("synchronized capture not taken: another capture is in progress"));
+#endif//RENDERDOC_PLUGIN_SYNC
+
+	if (Scheduler->IsRangeActive())
+	{
+		TickRangeCapture();
+		return;
+	}
+
+	if (!CaptureTriggerFile.IsEmpty())
+		PollCaptureTriggerFile();
+
+	FString FlythroughLabel;
+	if (Flythrough.IsRunning() && Flythrough.Tick(DeltaTime, FlythroughLabel) && CaptureEntireFrame(FlythroughLabel))
+		Flythrough.OnCaptureAccepted();
+
+	// Runs right before the sequences are evaluated for this tick, so the capture
+	// armed here starts at this very frame boundary (see OnBeginFrame):
+#if RENDERDOC_PLUGIN_SEQUENCER
+	FString SequenceLabel;
+	if (SequenceCapture.HasScheduledFrames() && Scheduler->IsIdle() && SequenceCapture.Tick(SequenceLabel))
+		CaptureEntireFrame(SequenceLabel);
+#endif//RENDERDOC_PLUGIN_SEQUENCER
+
+	FString ABLabel;
+	if (ABCapture.IsRunning() && Scheduler->IsIdle() && ABCapture.Tick(ABLabel) && !CaptureEntireFrame(ABLabel))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture: the capture was not taken; restoring the console variables"));
+		ABCapture.Cancel();
+	}
+
+	FString MedianLabel;
+	if (MedianCapture.IsRunning() && Scheduler->IsIdle() && MedianCapture.Tick(MedianLabel) && !CaptureEntireFrame(MedianLabel))
+		MedianCapture.Cancel();
+
+	FString TriggerReason;
+	if (StatTriggers.IsEnabled() && StatTriggers.Tick(TriggerReason) && CaptureEntireFrame())
+	{
+		UE_LOG(RenderDocPlugin, Log, TEXT("stat trigger fired: %s; capturing the next frame"), *TriggerReason);
+		StatTriggers.OnCaptureArmed();
+	}
+
 #if WITH_EDITOR
-	FRenderDocPluginNotification::Get().ShowNotification( NSLOCTEXT("LaunchRenderDocGUI", "LaunchRenderDocGUIShow", "Launching RenderDoc GUI") );
-#else
-	// TODO: if there is no editor, notify via game viewport text
+	if (Scheduler->IsIdle() && !ViewportCaptureClient.IsValid())
+		ShaderDebugInfo.Tick();
 #endif//WITH_EDITOR
+}
+
+void FRenderDocPluginModule::BeginRangeCapture()
+{
+	if (!RenderDocAPI || Scheduler->IsRangeActive())
+		return;
+
+	if (!Scheduler->IsIdle() || ViewportCaptureClient.IsValid())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("range capture not started: a frame capture is already in progress"));
+		return;
+	}
+
+	Scheduler->BeginRange(FMath::Max(1, RenderDocSettings.RangeCaptureMaxFrames));
+}
+
+void FRenderDocPluginModule::EndRangeCapture()
+{
+	Scheduler->EndRange();
+}
+
+void FRenderDocPluginModule::TickRangeCapture()
+{
+	// RenderDoc keeps the serialized API calls and resource contents of the whole
+	// range in memory until EndFrameCapture, so the growth of the process memory
+	// is a fair (if pessimistic) estimate of the size of the capture (the frame
+	// cap is enforced by the scheduler):
+	const uint64 UsedMemory = FPlatformMemory::GetStats().UsedPhysical;
+	const uint64 GrowthMB = (UsedMemory > RangeCaptureBaseMemory) ? (UsedMemory - RangeCaptureBaseMemory) / (1024 * 1024) : 0;
+
+	FString MemoryReason;
+	if (!MemoryGuard.CheckDuringCapture(MemoryReason))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("range capture ended early by the memory guard: %s"), *MemoryReason);
+		EndRangeCapture();
+	}
+	else if (GrowthMB >= (uint64)FMath::Max(1, RenderDocSettings.RangeCaptureMaxMB))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("range capture reached its memory cap (%llu MB, RangeCaptureMaxMB=%d); ending it"), GrowthMB, RenderDocSettings.RangeCaptureMaxMB);
+		EndRangeCapture();
+	}
+}
+
+void FRenderDocPluginModule::OnPostLoadMap()
+{
+	// Picked up at the next frame boundary; a range capture still recording
+	// from boot (or from the previous map) simply keeps going:
+	if (!Scheduler->IsRangeActive())
+		Scheduler->ArmFirstFrames(MapLoadCaptureFrames);
+}
+
+void FRenderDocPluginModule::SetCaptureOption(RENDERDOC_CaptureOption Option, uint32 Value)
+{
+	if (AppliedCaptureOptions[Option] == Value)
+		return;
+
+	int ok = RenderDocAPI->SetCaptureOptionU32(Option, Value); check(ok);
+	AppliedCaptureOptions[Option] = Value;
+}
+
+void FRenderDocPluginModule::ApplyCaptureOptions()
+{
+	const FRenderDocPluginSettings& Settings = RenderDocSettings;
+
+	// The downgrade only applies to the capture being armed; the next call restores
+	// the configured values:
+	const bool bDowngrade = bDowngradeNextCapture;
+	bDowngradeNextCapture = false;
+
+	// Command lists recorded in parallel (RHI thread, parallel translation) before
+	// the capture starts would otherwise be left out of it:
+	const bool bCaptureAllCmdLists = Settings.bCaptureAllCmdLists || (GRHIThread != NULL);
+
+	// Each option is set once, with its effective value, so that unchanged values
+	// never reach RenderDoc (see SetCaptureOption):
+	SetCaptureOption(eRENDERDOC_Option_AllowVSync,                 Settings.bAllowVSync                 ? 1 : 0);
+	SetCaptureOption(eRENDERDOC_Option_APIValidation,              Settings.bAPIValidation              ? 1 : 0);
+	SetCaptureOption(eRENDERDOC_Option_CaptureCallstacks,          Settings.bCaptureCallStacks          ? 1 : 0);
+	SetCaptureOption(eRENDERDOC_Option_CaptureCallstacksOnlyDraws, Settings.bCaptureCallStacksOnlyDraws ? 1 : 0);
+	SetCaptureOption(eRENDERDOC_Option_DelayForDebugger,           (uint32)FMath::Max(0, Settings.DelayForDebugger));
+	SetCaptureOption(eRENDERDOC_Option_VerifyMapWrites,            Settings.bVerifyMapWrites            ? 1 : 0);
+	SetCaptureOption(eRENDERDOC_Option_RefAllResources,            (Settings.bRefAllResources && !bDowngrade) ? 1 : 0);
+	SetCaptureOption(eRENDERDOC_Option_SaveAllInitials,            (Settings.bSaveAllInitials && !bDowngrade) ? 1 : 0);
+	SetCaptureOption(eRENDERDOC_Option_CaptureAllCmdLists,         bCaptureAllCmdLists                  ? 1 : 0);
+
+	// The statistics of a preset only cover captures taken with its very options; a
+	// downgraded capture, or one with command lists forced on, counts as "Custom":
+	const bool bDowngraded = bDowngrade && (Settings.bRefAllResources || Settings.bSaveAllInitials);
+	const bool bCustom = bDowngraded || (bCaptureAllCmdLists != Settings.bCaptureAllCmdLists);
+	CapturePreset = bCustom ? FString(TEXT("Custom")) : Settings.Preset;
+}
+
+bool FRenderDocPluginModule::CheckMemoryBudget(const FString& Label)
+{
+	FString Reason;
+	const bool bExpensiveOptions = (RenderDocSettings.bRefAllResources || RenderDocSettings.bSaveAllInitials);
+	switch (MemoryGuard.CheckBeforeCapture(bExpensiveOptions, Reason))
+	{
+	case FRenderDocPluginMemoryGuard::Downgrade :
+		UE_LOG(RenderDocPlugin, Warning, TEXT("memory guard: capturing without RefAllResources/SaveAllInitials (%s)"), *Reason);
+		bDowngradeNextCapture = true;
+		return(true);
+	case FRenderDocPluginMemoryGuard::Refuse :
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("memory guard: capture refused (%s)"), *Reason);
+		FRenderDocPluginEvent Requested (ERenderDocCaptureStage::Requested);
+		Requested.Label = Label;
+		FRenderDocPluginEvent Refused (ERenderDocCaptureStage::Failed);
+		Refused.Label = Label;
+		Refused.Message = FString::Printf(TEXT("refused by the memory guard: %s"), *Reason);
+		Events.Post(Requested);
+		Events.Post(Refused);
+		return(false);
+	}
+	default :
+		return(true);
+	}
+}
+
+void FRenderDocPluginModule::SelectPreset(const TArray<FString>& Args)
+{
+	if (Args.Num() < 1)
+	{
+		for (const FRenderDocPluginPreset& Preset : FRenderDocPluginPresets::Get())
+			UE_LOG(RenderDocPlugin, Display, TEXT("%c %-18s %s [%s]"), (RenderDocSettings.Preset == Preset.Name) ? '*' : ' ',
+				Preset.Name, Preset.Description, *FRenderDocPluginPresets::DescribeStats(Preset.Name));
+		return;
+	}
 
+	if (!FRenderDocPluginPresets::Apply(Args[0], RenderDocSettings))
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("unknown capture preset '%s'"), *Args[0]);
+		return;
+	}
+	UE_LOG(RenderDocPlugin, Log, TEXT("capture preset '%s' selected (%s)"), *RenderDocSettings.Preset, *FRenderDocPluginPresets::DescribeStats(RenderDocSettings.Preset));
+}
+
+void FRenderDocPluginModule::StartFlythrough(const FString& BookmarksFile, const FString& Preset, bool bExitWhenDone)
+{
+	if (Flythrough.IsRunning())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("flythrough: already running"));
+		return;
+	}
+
+	// Every run captures with the same options, regardless of the user settings,
+	// which are given back once the run is over:
+	const FRenderDocPluginSettings UserSettings = RenderDocSettings;
+	if (!FRenderDocPluginPresets::Apply(Preset, RenderDocSettings))
+	{
+		UE_LOG(RenderDocPlugin, Error, TEXT("flythrough: unknown capture preset '%s'"), *Preset);
+		return;
+	}
+	FRenderDocPluginSettings* Settings = &RenderDocSettings;
+	Flythrough.Start(BookmarksFile.IsEmpty() ? FString() : FPaths::ConvertRelativePathToFull(BookmarksFile), RenderDocSettings.Preset, bExitWhenDone,
+		[Settings, UserSettings]()
+		{
+			*Settings = UserSettings;
+		});
+}
+
+void FRenderDocPluginModule::StartABCapture(const TArray<FString>& Args)
+{
+	if (!RenderDocAPI)
+		return;
+
+	if (Flythrough.IsRunning() || Scheduler->IsRangeActive())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("A/B capture not started: a flythrough or range capture is in progress"));
+		return;
+	}
+
+	ABCapture.Start(Args);
+}
+
+#if RENDERDOC_PLUGIN_SYNC
+bool FRenderDocPluginModule::TickCaptureSync(float DeltaTime)
+{
+	// With RenderDoc, the group is polled at frame boundaries instead (see Tick):
+	if (RenderDocAPI)
+		return(true);
+
+	FString SyncLabel;
+	if (CaptureSync.Tick(SyncLabel) && GEngine && !CaptureSync.GetFallbackCommand().IsEmpty())
+		GEngine->Exec(NULL, *CaptureSync.GetFallbackCommand());
+	return(true);
+}
+#endif//RENDERDOC_PLUGIN_SYNC
+
+void FRenderDocPluginModule::StartMedianCapture(const TArray<FString>& Args)
+{
+	if (!RenderDocAPI)
+		return;
+
+	if (Flythrough.IsRunning() || Scheduler->IsRangeActive())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("median capture not started: a flythrough or range capture is in progress"));
+		return;
+	}
+
+	MedianCapture.Start((Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 0);
+}
+
+#if RENDERDOC_PLUGIN_SEQUENCER
+void FRenderDocPluginModule::ScheduleSequenceFrames(const FString& Frames)
+{
+	TArray<FString> Entries;
+	Frames.ParseIntoArray(Entries, TEXT("+"), true);
+	for (const FString& Entry : Entries)
+	{
+		FString Sequence, Frame;
+		if (Entry.Split(TEXT("@"), &Sequence, &Frame) && !Sequence.IsEmpty() && Frame.IsNumeric())
+			SequenceCapture.Schedule(Sequence, FCString::Atoi(*Frame), 0.0f);
+		else
+			UE_LOG(RenderDocPlugin, Warning, TEXT("ignoring malformed sequence frame '%s' (expected <sequence>@<frame>)"), *Entry);
+	}
+}
+#endif//RENDERDOC_PLUGIN_SEQUENCER
+
+void FRenderDocPluginModule::PollCaptureTriggerFile()
+{
+	const double Now = FPlatformTime::Seconds();
+	if (Now - TriggerFilePollTime < 0.5)
+		return;
+	TriggerFilePollTime = Now;
+
+	if (!IFileManager::Get().FileExists(*CaptureTriggerFile))
+		return;
+
+	UE_LOG(RenderDocPlugin, Log, TEXT("capture requested through trigger file '%s'"), *CaptureTriggerFile);
+	IFileManager::Get().Delete(*CaptureTriggerFile);
+	CaptureFrame();
+}
+
+FString FRenderDocPluginModule::DescribeCaptureOptions() const
+{
+	static const struct { RENDERDOC_CaptureOption Option; const TCHAR* Name; } Options [] =
+	{
+		{ eRENDERDOC_Option_AllowVSync,                 TEXT("AllowVSync") },
+		{ eRENDERDOC_Option_APIValidation,              TEXT("APIValidation") },
+		{ eRENDERDOC_Option_CaptureCallstacks,          TEXT("CaptureCallstacks") },
+		{ eRENDERDOC_Option_CaptureCallstacksOnlyDraws, TEXT("CaptureCallstacksOnlyDraws") },
+		{ eRENDERDOC_Option_DelayForDebugger,           TEXT("DelayForDebugger") },
+		{ eRENDERDOC_Option_VerifyMapWrites,            TEXT("VerifyMapWrites") },
+		{ eRENDERDOC_Option_RefAllResources,            TEXT("RefAllResources") },
+		{ eRENDERDOC_Option_SaveAllInitials,            TEXT("SaveAllInitials") },
+		{ eRENDERDOC_Option_CaptureAllCmdLists,         TEXT("CaptureAllCmdLists") },
+	};
+
+	FString Description;
+	for (const auto& Entry : Options)
+		Description += FString::Printf(TEXT("%s%s=%u"), Description.IsEmpty() ? TEXT("") : TEXT(" "), Entry.Name, AppliedCaptureOptions[Entry.Option]);
+	return(Description);
+}
+
+void FRenderDocPluginModule::OnCaptureEvent(const FRenderDocPluginEvent& Event)
+{
+	switch (Event.Stage)
+	{
+	case ERenderDocCaptureStage::Requested :
+		CurrentCapture = FRenderDocCaptureInfo();
+		CurrentCapture.Preset = RenderDocSettings.Preset;
+		CurrentCapture.Options = DescribeCaptureOptions();
+		CurrentCapture.RequestedFrame = GFrameCounter;
+		bCaptureInFlight = true;
+		CaptureRequested.Broadcast(CurrentCapture);
+		break;
+
+	case ERenderDocCaptureStage::Capturing :
+		CaptureStarted.Broadcast(CurrentCapture);
+		break;
+
+	case ERenderDocCaptureStage::Finished :
+		if (!bCaptureInFlight)
+			break;
+		bCaptureInFlight = false;
+		CurrentCapture.CaptureFile = Event.CaptureFile;
+		CurrentCapture.SizeBytes = IFileManager::Get().FileSize(*Event.CaptureFile);
+		CaptureFinished.Broadcast(CurrentCapture);
+		break;
+
+	case ERenderDocCaptureStage::Failed :
+		// Failures after Finished concern the capture store, not the capture:
+		if (!bCaptureInFlight)
+			break;
+		bCaptureInFlight = false;
+		CurrentCapture.FailureReason = Event.Message;
+		CaptureFailed.Broadcast(CurrentCapture);
+		break;
+
+	default :
+		break;
+	}
+}
+
+void FRenderDocPluginModule::StartRenderDoc(FString FrameCaptureBaseDirectory, double CaptureSeconds, const FString& Label)
+{
 	FString NewestCapture = GetNewestCapture(FrameCaptureBaseDirectory);
-	FString ArgumentString = FString::Printf(TEXT("\"%s\""), *FPaths::ConvertRelativePathToFull(NewestCapture).Append(TEXT(".log")));
+	if (NewestCapture.IsEmpty())
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("RenderDoc did not report any capture"));
+		FRenderDocPluginEvent NoCapture (ERenderDocCaptureStage::Failed);
+		NoCapture.Label = Label;
+		NoCapture.Message = TEXT("RenderDoc did not report any capture");
+		Events.Post(NoCapture);
+		return;
+	}
+
+	FString CaptureFile = FPaths::ConvertRelativePathToFull(NewestCapture).Append(TEXT(".log"));
+	const int64 CaptureSize = IFileManager::Get().FileSize(*CaptureFile);
+	FRenderDocPluginPresets::RecordCapture(CapturePreset, CaptureSeconds, CaptureSize);
+
+	if (!CaptureMover)
+	{
+		OnCaptureAvailable(CaptureFile, Label);
+		return;
+	}
 
-	if (!NewestCapture.IsEmpty())
+	// The GUI is only launched once the capture reached its final location, so
+	// that it never holds a handle to a scratch file about to be deleted:
+	FRenderDocPluginEvent Migrating (ERenderDocCaptureStage::Migrating, CaptureFile, 0, CaptureSize);
+	Migrating.Label = Label;
+	Events.Post(Migrating);
+	CaptureMover->Enqueue(CaptureFile, Label, [CaptureFile, Label](const FString& FinalFile)
 	{
-		// This is the new, recommended way of launching the RenderDoc GUI:
-		if (!RenderDocAPI->IsRemoteAccessConnected())
+		// The module may have been shut down by the time the game thread runs this:
+		RunAsyncTask(ENamedThreads::GameThread, [CaptureFile, Label, FinalFile]()
 		{
-			uint32 PID = (sizeof(TCHAR) == sizeof(char)) ?
-			  RenderDocAPI->LaunchReplayUI(true, (const char*)(*ArgumentString))
-			: RenderDocAPI->LaunchReplayUI(true, TCHAR_TO_ANSI(*ArgumentString));
+			FRenderDocPluginModule* Plugin = static_cast<FRenderDocPluginModule*>(IRenderDocPlugin::GetIfLoaded());
+			if (Plugin)
+				Plugin->OnCaptureAvailable(FinalFile.IsEmpty() ? CaptureFile : FinalFile, Label);
+		});
+	});
+}
+
+void FRenderDocPluginModule::OnCaptureAvailable(const FString& CaptureFile, const FString& Label)
+{
+	const int64 CaptureSize = IFileManager::Get().FileSize(*CaptureFile);
+
+	FRenderDocPluginEvent Launching (ERenderDocCaptureStage::Launching, CaptureFile, CaptureSize);
+	Launching.Label = Label;
+	Events.Post(Launching);
+	// Unattended flythrough and A/B captures are only listed in their manifest, and
+	// windowless processes (batch nodes, likely without a desktop) just log them:
+	if (!RenderDocSettings.bLaunchReplayUI || FRenderDocPluginNativeHandles::IsWindowless())
+		UE_LOG(RenderDocPlugin, Log, TEXT("capture available: %s"), *CaptureFile);
+	else if (!Flythrough.IsRunning() && !ABCapture.IsRunning())
+		LaunchReplayUI(CaptureFile);
+	FRenderDocPluginEvent Finished (ERenderDocCaptureStage::Finished, CaptureFile, CaptureSize);
+	Finished.Label = Label;
+	Events.Post(Finished);
+
+	if (RenderDocSettings.bUseCaptureStore)
+		ArchiveCapture(CaptureFile);
+}
+
+void FRenderDocPluginModule::LaunchReplayUI(const FString& CaptureFile)
+{
+	FString ArgumentString = FString::Printf(TEXT("\"%s\""), *CaptureFile);
+
+	// This is the new, recommended way of launching the RenderDoc GUI:
+	if (!RenderDocAPI->IsRemoteAccessConnected())
+	{
+		uint32 PID = (sizeof(TCHAR) == sizeof(char)) ?
+		  RenderDocAPI->LaunchReplayUI(true, (const char*)(*ArgumentString))
+		: RenderDocAPI->LaunchReplayUI(true, TCHAR_TO_ANSI(*ArgumentString));
 
 		if (0 == PID)
 			UE_LOG(LogTemp, Error, TEXT("Could not launch RenderDoc!!"));
-		}
 	}
+}
 
-#if WITH_EDITOR
-	FRenderDocPluginNotification::Get().ShowNotification( NSLOCTEXT("LaunchRenderDocGUI", "LaunchRenderDocGUIHide", "RenderDoc GUI Launched!") );
-#else
-	// TODO: if there is no editor, notify via game viewport text
-#endif//WITH_EDITOR
+void FRenderDocPluginModule::ArchiveCapture(const FString& CaptureFile)
+{
+	// Chunking and hashing reads the entire capture, so keep it on the thread
+	// pool; the raw capture stays around until the next session (see StartupModule)
+	// since the RenderDoc GUI may still be reading it:
+	const FRenderDocPluginCaptureStore* Store = &CaptureStore;
+	FRenderDocPluginEventChannel* Channel = &Events;
+	Channel->Post(FRenderDocPluginEvent(ERenderDocCaptureStage::Archiving, CaptureFile));
+	StoreTasks.RemoveAll([](const TFuture<void>& Task) { return(Task.IsReady()); });
+	StoreTasks.Add(Async<void>(EAsyncExecution::ThreadPool, [Store, Channel, CaptureFile]()
+	{
+		const bool bArchived = Store->Ingest(CaptureFile);
+		Channel->Post(FRenderDocPluginEvent(bArchived ? ERenderDocCaptureStage::Archived : ERenderDocCaptureStage::Failed, CaptureFile));
+	}));
+}
+
+void FRenderDocPluginModule::OpenStoredCapture(const TArray<FString>& Args)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(RenderDocPlugin, Warning, TEXT("usage: RenderDoc.OpenCapture <capture name>"));
+		return;
+	}
+
+	const FString CaptureName = FPaths::GetBaseFilename(Args[0]);
+	const FRenderDocPluginCaptureStore* Store = &CaptureStore;
+	StoreTasks.RemoveAll([](const TFuture<void>& Task) { return(Task.IsReady()); });
+	StoreTasks.Add(Async<void>(EAsyncExecution::ThreadPool, [Store, CaptureName]()
+	{
+		FString CaptureFile = Store->Rebuild(CaptureName);
+		if (CaptureFile.IsEmpty())
+			return;
+		// The module may have been shut down in the meantime:
+		RunAsyncTask(ENamedThreads::GameThread, [CaptureFile]()
+		{
+			FRenderDocPluginModule* Plugin = static_cast<FRenderDocPluginModule*>(IRenderDocPlugin::GetIfLoaded());
+			if (Plugin && Plugin->IsCaptureAvailable())
+				Plugin->LaunchReplayUI(CaptureFile);
+		});
+	}));
 }
 
 FString FRenderDocPluginModule::GetNewestCapture(FString BaseDirectory)
@@ -352,13 +1409,44 @@ FString FRenderDocPluginModule::GetNewestCapture(FString BaseDirectory)
 
 void FRenderDocPluginModule::ShutdownModule()
 {
-	if (GUsingNullRHI)
+	delete(Scheduler);
+	Scheduler = NULL;
+
+#if RENDERDOC_PLUGIN_SYNC
+	FTicker::GetCoreTicker().RemoveTicker(CaptureSyncTickHandle);
+	CaptureSync.Leave();
+#endif//RENDERDOC_PLUGIN_SYNC
+
+	// The store tasks reference the capture store and the event channel:
+	for (TFuture<void>& Task : StoreTasks)
+		Task.Wait();
+	StoreTasks.Empty();
+
+	FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	FCoreUObjectDelegates::PostLoadMap.Remove(PostLoadMapHandle);
+	Events.OnCaptureEvent().RemoveAll(&Flythrough);
+	Flythrough.Cancel();
+	Events.OnCaptureEvent().RemoveAll(&ABCapture);
+	ABCapture.Cancel();
+	Events.OnCaptureEvent().RemoveAll(&MedianCapture);
+	MedianCapture.Cancel();
+#if RENDERDOC_PLUGIN_HUD
+	HUD.Ignore(Events);
+#endif//RENDERDOC_PLUGIN_HUD
+	Events.OnCaptureEvent().RemoveAll(this);
+
+	if (GUsingNullRHI || !IsRenderDocRequested())
 		return;
 
 #if WITH_EDITOR
+	FRenderDocPluginNotification::Get().Ignore(Events);
 	delete(EditorExtensions);
 #endif//WITH_EDITOR
 
+	delete(CaptureMover);
+	CaptureMover = NULL;
+
 	Loader.Release();
 
 	RenderDocAPI = NULL;
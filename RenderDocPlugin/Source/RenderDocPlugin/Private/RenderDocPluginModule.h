@@ -28,6 +28,20 @@
 
 #include "RenderDocPluginLoader.h"
 #include "RenderDocPluginSettings.h"
+#include "RenderDocPluginCaptureStore.h"
+#include "RenderDocPluginPresets.h"
+#include "RenderDocPluginCaptureMover.h"
+#include "RenderDocPluginEvents.h"
+#include "RenderDocPluginStatTriggers.h"
+#include "RenderDocPluginShaderDebugInfo.h"
+#include "RenderDocPluginMemoryGuard.h"
+#include "RenderDocPluginFlythrough.h"
+#include "RenderDocPluginSequenceCapture.h"
+#include "RenderDocPluginABCapture.h"
+#include "RenderDocPluginMedianCapture.h"
+#include "RenderDocPluginCaptureSync.h"
+#include "RenderDocPluginHUD.h"
+#include "RenderDocPluginCaptureScheduler.h"
 
 #if WITH_EDITOR
 #include "Editor/LevelEditor/Public/LevelEditor.h"
@@ -44,31 +58,126 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(RenderDocPlugin, Log, All);
 
-class FRenderDocPluginModule : public IRenderDocPlugin
+class FRenderDocPluginModule : public IRenderDocPlugin, private IRenderDocCaptureBackend
 {
 public:	
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+	static void RunAsyncTask(ENamedThreads::Type Where, TFunction<void()> What);
+
+	// Scoped capture API (see IRenderDocPlugin):
+	virtual bool IsCaptureAvailable() const override;
+	virtual void BeginScopedCapture(const TCHAR* Label) override;
+	virtual void EndScopedCapture() override;
+
+	// Capture lifecycle delegates (see IRenderDocPlugin):
+	virtual FOnRenderDocCapture& OnCaptureRequested() override { return(CaptureRequested); }
+	virtual FOnRenderDocCapture& OnCaptureStarted() override   { return(CaptureStarted); }
+	virtual FOnRenderDocCapture& OnCaptureFinished() override  { return(CaptureFinished); }
+	virtual FOnRenderDocCapture& OnCaptureFailed() override    { return(CaptureFailed); }
+
 private:
-	// Tick made possible via the dummy input device declared below:
+	// Engine frame boundaries (FCoreDelegates, game thread); OnBeginFrame also
+	// ticks the plugin:
+	void OnBeginFrame();
+	void OnEndFrame();
 	void Tick(float DeltaTime);
-	class FRenderDocDummyInputDevice;
-	// Mandatory IInputDeviceModule override that spawns the dummy input device:
-	virtual TSharedPtr< class IInputDevice > CreateInputDevice(const TSharedRef< FGenericApplicationMessageHandler >& InMessageHandler) override;
+	FDelegateHandle BeginFrameHandle;
+	FDelegateHandle EndFrameHandle;
 
-	void BeginCapture();
+	// The capture is matched against the window of ViewportClient if given, or else
+	// against the window with the focus; EndCapture() uses the same window:
+	void BeginCapture(UGameViewportClient* ViewportClient = NULL);
 	void EndCapture();
+	RENDERDOC_WindowHandle CaptureWindowHandle;
+
+	// Pushes the capture options of RenderDocSettings to RenderDoc, skipping the
+	// ones whose value has not changed since they were last applied, and sets the
+	// preset the options applied amount to (CapturePreset):
+	void ApplyCaptureOptions();
+	void SetCaptureOption(RENDERDOC_CaptureOption Option, uint32 Value);
+	uint32 AppliedCaptureOptions [eRENDERDOC_Option_DebugOutputMute + 1];
+
+	// Memory budget (see FRenderDocPluginMemoryGuard): false if the capture must be
+	// refused; may also flag the next capture to drop RefAllResources/SaveAllInitials.
+	// Label is reported with the refusal:
+	bool CheckMemoryBudget(const FString& Label = FString());
+	FRenderDocPluginMemoryGuard MemoryGuard;
+	bool bDowngradeNextCapture;
+
+	// Capture presets (see FRenderDocPluginPresets):
+	void SelectPreset(const TArray<FString>& Args);
 
   friend class SRenderDocPluginToolbar;
 	void CaptureFrame();
 	void CaptureCurrentViewport();	
-	void CaptureEntireFrame();
+	bool CaptureEntireFrame(const FString& Label = FString());
+
+	// Deferred viewport capture: brackets the next natural draw of a game viewport
+	// instead of forcing a synchronous Viewport->Draw():
+	void CaptureNextViewportDraw(UGameViewportClient* ViewportClient);
+
+	// World-scoped capture: brackets the viewport draw of a single Play-In-Editor
+	// instance (a client or a listen server), identified by its PIE instance number:
+	void CaptureWorld(int32 PIEInstance);
+	void CaptureWorld(const TArray<FString>& Args);
+	static FString DescribeWorld(const FWorldContext& Context);
+	void OnViewportBeginDraw();
+	void OnViewportEndDraw();
+	TWeakObjectPtr<UGameViewportClient> ViewportCaptureClient;
+	FDelegateHandle ViewportBeginDrawHandle;
+	FDelegateHandle ViewportEndDrawHandle;
+	bool bViewportCaptureStarted;
+
+	// Render thread side of the scoped capture API; ScopedCaptureDepth folds nested
+	// regions into the outermost one:
+	void BeginScopedCapture_RenderThread(const FString& Label);
+	void EndScopedCapture_RenderThread();
+	int32 ScopedCaptureDepth;
+	bool bScopedCaptureSkipped;
+	FString ScopedCaptureLabel;
+
+	// Whether a capture is in progress, as seen from the render thread timeline
+	// (RenderDoc itself only learns about it later, on the RHI thread):
+	bool bCapturing_RenderThread;
+
+	// Capture file name template; labeled captures temporarily replace it:
+	void SetCapturePathTemplate(const FString& PathTemplate);
+	FString GetLabeledPathTemplate(const FString& Label) const;
+	FString CapturePathTemplate;
+
+	// Label of the next capture started by BeginCapture() (consumed by it), and
+	// label of the capture in progress, reported with its events:
+	FString NextCaptureLabel;
+	FString CaptureLabel;
+
+	// Feeds the lifecycle delegates from the event channel, on the game thread:
+	void OnCaptureEvent(const FRenderDocPluginEvent& Event);
+	FString DescribeCaptureOptions() const;
+	FOnRenderDocCapture CaptureRequested;
+	FOnRenderDocCapture CaptureStarted;
+	FOnRenderDocCapture CaptureFinished;
+	FOnRenderDocCapture CaptureFailed;
+	FRenderDocCaptureInfo CurrentCapture;
+	bool bCaptureInFlight;
 
-	void StartRenderDoc(FString FrameCaptureBaseDirectory);
+	// Measured on the RHI thread (see FrameCapturer), reported with the capture:
+	double CaptureBeginSeconds;
+	int64 CaptureFirstRenderFrame;
+
+	void StartRenderDoc(FString FrameCaptureBaseDirectory, double CaptureSeconds, const FString& Label);
 	FString GetNewestCapture(FString BaseDirectory);
+	void LaunchReplayUI(const FString& CaptureFile);
+	void OnCaptureAvailable(const FString& CaptureFile, const FString& Label);
+
+	// Capture store: archive finished captures, rebuild them on demand:
+	void ArchiveCapture(const FString& CaptureFile);
+	void OpenStoredCapture(const TArray<FString>& Args);
+
+	// Ingestions and rebuilds in flight on the thread pool, waited for on shutdown:
+	TArray< TFuture<void> > StoreTasks;
 
- 	static void RunAsyncTask(ENamedThreads::Type Where, TFunction<void()> What);
 	
 	// UE4-related: enable DrawEvents during captures, if necessary:
 	bool UE4_GEmitDrawEvents_BeforeCapture;
@@ -77,18 +186,81 @@ private:
 
 	FRenderDocPluginLoader Loader;
 	FRenderDocPluginSettings RenderDocSettings;
+	FRenderDocPluginCaptureStore CaptureStore;
+	FRenderDocPluginCaptureMover* CaptureMover;
+	FRenderDocPluginEventChannel Events;
+	FRenderDocPluginStatTriggers StatTriggers;
 	FRenderDocPluginLoader::RENDERDOC_API_CONTEXT* RenderDocAPI;
 
-	// Tracks the frame count (tick number) for a full frame capture:
-	uint32 TickNumber;
+	// When frame, range and startup captures begin and end (see
+	// FRenderDocPluginCaptureScheduler); this module is its RenderDoc backend:
+	FRenderDocPluginCaptureScheduler* Scheduler;
+	virtual bool AdmitScheduledCapture(const FRenderDocCaptureRequest& Request) override;
+	virtual void BeginScheduledCapture(const FRenderDocCaptureRequest& Request) override;
+	virtual void EndScheduledCapture(const FRenderDocCaptureRequest& Request, uint64 Frames, double Seconds) override;
+
+	// Range captures: record every frame between two requests (toggle, or key press
+	// and release), within the safety caps of RenderDocSettings:
+	void BeginRangeCapture();
+	void EndRangeCapture();
+	void TickRangeCapture();
+	uint64 RangeCaptureBaseMemory;
+
+	// Boot-time captures are armed on the scheduler from the command line; with
+	// -RenderDocCaptureAfterMapLoad, the first frames are armed again after every
+	// map load:
+	void OnPostLoadMap();
+	FDelegateHandle PostLoadMapHandle;
+	int32 MapLoadCaptureFrames;
+
+	// Performance-regression flythrough (see FRenderDocPluginFlythrough):
+	void StartFlythrough(const FString& BookmarksFile, const FString& Preset, bool bExitWhenDone);
+	FRenderDocPluginFlythrough Flythrough;
+
+#if RENDERDOC_PLUGIN_SEQUENCER
+	// Captures of specific Sequencer frames (see FRenderDocPluginSequenceCapture):
+	void ScheduleSequenceFrames(const FString& Frames);
+	FRenderDocPluginSequenceCapture SequenceCapture;
+#endif//RENDERDOC_PLUGIN_SEQUENCER
+
+	// Paired captures under two sets of console variables (see FRenderDocPluginABCapture):
+	void StartABCapture(const TArray<FString>& Args);
+	FRenderDocPluginABCapture ABCapture;
+
+	// Capture of a typical frame, for baselines (see FRenderDocPluginMedianCapture):
+	void StartMedianCapture(const TArray<FString>& Args);
+	FRenderDocPluginMedianCapture MedianCapture;
+
+	// Captures of the same frame by several processes (see FRenderDocPluginCaptureSync);
+	// polled by a core ticker in processes without RenderDoc:
+#if RENDERDOC_PLUGIN_SYNC
+	bool TickCaptureSync(float DeltaTime);
+	FRenderDocPluginCaptureSync CaptureSync;
+	FDelegateHandle CaptureSyncTickHandle;
+#endif//RENDERDOC_PLUGIN_SYNC
+
+#if RENDERDOC_PLUGIN_HUD
+	FRenderDocPluginHUD HUD;
+#endif//RENDERDOC_PLUGIN_HUD
+
+	// Capture requests from other processes (see PollCaptureTriggerFile):
+	void PollCaptureTriggerFile();
+	FString CaptureTriggerFile;
+	double TriggerFilePollTime;
+
+	// Preset the applied capture options amount to (see ApplyCaptureOptions), under
+	// which the next capture is recorded, and the moment (render thread clock)
+	// RenderDoc was asked to start capturing:
+	FString CapturePreset;
+	double CaptureStartTime;
 
 #if WITH_EDITOR
+	FRenderDocPluginShaderDebugInfo ShaderDebugInfo;
   FRenderDocPluginEditorExtension* EditorExtensions;
 #endif//WITH_EDITOR
 
 private:
 	// TODO: refactor the plugin into subclasses:
-	class InputDevice;
 	class RenderDocLoader;
 	class Settings;
 	class FrameCapturer;
@@ -0,0 +1,163 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginNativeHandles.h"
+
+#include "RenderDocPluginModule.h"
+
+#if RENDERDOC_PLUGIN_SLATE
+#include "SlateBasics.h"
+#endif//RENDERDOC_PLUGIN_SLATE
+#include "Runtime/Launch/Resources/Version.h"
+
+// The OpenGL and SDL2 libraries are only linked where RenderDoc can be used (see
+// RenderDocPlugin.Build.cs):
+#ifndef RENDERDOC_PLUGIN_OPENGL
+#define RENDERDOC_PLUGIN_OPENGL !UE_BUILD_SHIPPING
+#endif
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX && RENDERDOC_PLUGIN_OPENGL
+#include "SDL.h"
+#include "SDL_syswm.h"
+#endif
+
+// RenderDoc identifies Vulkan devices by the dispatch table of their instance (from
+// renderdoc_app.h 1.1.2 onwards):
+#ifndef RENDERDOC_DEVICEPOINTER_FROM_VKINSTANCE
+#define RENDERDOC_DEVICEPOINTER_FROM_VKINSTANCE(inst) (*((void **)(inst)))
+#endif
+
+// The Vulkan instance is only exposed by the RHI interface of later engines:
+#define RENDERDOC_RHI_HAS_NATIVE_INSTANCE (ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 20)
+
+RENDERDOC_DevicePointer FRenderDocPluginNativeHandles::GetDevicePointer()
+{
+	if (!GDynamicRHI)
+		return(NULL);
+
+	const TCHAR* RHIName = GDynamicRHI->GetName();
+
+	if (FCString::Strcmp(RHIName, TEXT("OpenGL")) == 0)
+	{
+		// The OpenGL RHI has no notion of a native device; RenderDoc tracks its
+		// contexts, and the rendering one is current on this thread:
+#if PLATFORM_WINDOWS && RENDERDOC_PLUGIN_OPENGL
+		return(wglGetCurrentContext());
+#elif PLATFORM_LINUX && RENDERDOC_PLUGIN_OPENGL
+		return(SDL_GL_GetCurrentContext());
+#else
+		return(NULL);
+#endif
+	}
+
+	if (FCString::Strcmp(RHIName, TEXT("Vulkan")) == 0)
+	{
+#if RENDERDOC_RHI_HAS_NATIVE_INSTANCE
+		void* Instance = GDynamicRHI->RHIGetNativeInstance();
+		return(Instance ? RENDERDOC_DEVICEPOINTER_FROM_VKINSTANCE(Instance) : NULL);
+#else
+		// RHIGetNativeDevice() returns the VkDevice, which RenderDoc does not know
+		// about; any device will do, since there is only one:
+		return(NULL);
+#endif
+	}
+
+	return(GDynamicRHI->RHIGetNativeDevice());
+}
+
+bool FRenderDocPluginNativeHandles::IsWindowless()
+{
+	static const bool bWindowless = FParse::Param(FCommandLine::Get(), TEXT("RenderOffscreen"))
+	                             || FParse::Param(FCommandLine::Get(), TEXT("RenderDocAnyWindow"))
+	                             || IsRunningCommandlet();
+	return(bWindowless);
+}
+
+RENDERDOC_WindowHandle FRenderDocPluginNativeHandles::GetWindowHandle()
+{
+	// Whatever window happens to be active (if any) is not the one being rendered:
+	if (IsWindowless())
+		return(NULL);
+
+#if PLATFORM_WINDOWS
+	return(GetActiveWindow());
+#elif RENDERDOC_PLUGIN_SLATE
+	if (!FSlateApplication::IsInitialized())
+		return(NULL);
+
+	TSharedPtr<SWindow> Window = FSlateApplication::Get().GetActiveTopLevelWindow();
+	if (!Window.IsValid() && GEngine && GEngine->GameViewport)
+		Window = GEngine->GameViewport->GetWindow();
+	if (!Window.IsValid() || !Window->GetNativeWindow().IsValid())
+		return(NULL);
+
+	return(ToRenderDocWindow(Window->GetNativeWindow()->GetOSWindowHandle()));
+#else
+	// Without Slate, the game viewport is the only window around:
+	return(GEngine ? GetViewportWindowHandle(GEngine->GameViewport) : NULL);
+#endif
+}
+
+RENDERDOC_WindowHandle FRenderDocPluginNativeHandles::GetViewportWindowHandle(UGameViewportClient* ViewportClient)
+{
+	if (IsWindowless() || !ViewportClient)
+		return(NULL);
+
+#if RENDERDOC_PLUGIN_SLATE
+	// With Slate, viewports (PIE ones included) are drawn into the back buffer of
+	// the window hosting them:
+	TSharedPtr<SWindow> Window = ViewportClient->GetWindow();
+	if (Window.IsValid() && Window->GetNativeWindow().IsValid())
+		return(ToRenderDocWindow(Window->GetNativeWindow()->GetOSWindowHandle()));
+#endif//RENDERDOC_PLUGIN_SLATE
+
+	FViewport* Viewport = ViewportClient->Viewport;
+	if (!Viewport || !Viewport->GetViewportRHI().IsValid())
+		return(NULL);
+	return(ToRenderDocWindow(Viewport->GetViewportRHI()->GetNativeWindow()));
+}
+
+RENDERDOC_WindowHandle FRenderDocPluginNativeHandles::ToRenderDocWindow(void* OSWindow)
+{
+#if PLATFORM_LINUX && RENDERDOC_PLUGIN_OPENGL && defined(SDL_VIDEO_DRIVER_X11)
+	// Linux windows are SDL windows, drawn to X11 windows that RenderDoc hooks:
+	SDL_SysWMinfo Info;
+	SDL_VERSION(&Info.version);
+	if (OSWindow && SDL_GetWindowWMInfo((SDL_Window*)OSWindow, &Info) && Info.subsystem == SDL_SYSWM_X11)
+		return((RENDERDOC_WindowHandle)(UPTRINT)Info.info.x11.window);
+	return(NULL);
+#elif PLATFORM_LINUX
+	// Without SDL or its X11 support, there is no window RenderDoc would know of; an
+	// SDL_Window* would be taken for one:
+	return(NULL);
+#else
+	return(OSWindow);
+#endif
+}
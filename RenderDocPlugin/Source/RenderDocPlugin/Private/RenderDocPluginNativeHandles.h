@@ -0,0 +1,68 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#include "RenderDocAPI/renderdoc_app.h"
+
+class UGameViewportClient;
+
+/**
+* Resolves the native handles RenderDoc matches captures against, for the RHI and
+* platform in use:
+*
+*   RHI       device pointer                      window handle
+*   D3D11/12  ID3D11Device / ID3D12Device         HWND
+*   OpenGL    HGLRC / GLXContext (current one)    HWND / X11 Window
+*   Vulkan    VkInstance dispatch table pointer   HWND / X11 Window
+*
+* Whatever cannot be resolved (an engine without access to the Vulkan instance, an
+* offscreen or windowless process, a headless node...) is NULL, which RenderDoc
+* treats as a wildcard matching any device or window.
+*/
+class FRenderDocPluginNativeHandles
+{
+public:
+	/** To be called where the RHI issues its native calls (RHI thread, or render thread without one). */
+	static RENDERDOC_DevicePointer GetDevicePointer();
+
+	/** To be called on the game thread; the top-level window with the focus (NULL when windowless). */
+	static RENDERDOC_WindowHandle GetWindowHandle();
+
+	/** To be called on the game thread; the window the viewport is presented in (NULL when windowless). */
+	static RENDERDOC_WindowHandle GetViewportWindowHandle(UGameViewportClient* ViewportClient);
+
+	/**
+	* True if the process renders without a window to present to: -RenderOffscreen,
+	* commandlets rendering with -AllowCommandletRendering, or -RenderDocAnyWindow
+	* (e.g. render target bakes and compute work that never reach the back buffer).
+	* Captures then match any window, and no viewport is assumed to be around.
+	*/
+	static bool IsWindowless();
+
+private:
+	/** The window RenderDoc knows of, for the OS window handle of a Slate window or RHI viewport. */
+	static RENDERDOC_WindowHandle ToRenderDocWindow(void* OSWindow);
+};
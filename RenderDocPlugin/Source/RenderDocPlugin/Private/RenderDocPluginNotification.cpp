@@ -30,10 +30,24 @@
 #include "SNotificationList.h"
 #include "NotificationManager.h"
 
-void FRenderDocPluginNotification::ShowNotification(const FText& Message)
+#define LOCTEXT_NAMESPACE "RenderDocPluginNotification"
+
+void FRenderDocPluginNotification::Listen(FRenderDocPluginEventChannel& Channel)
+{
+	CaptureEventHandle = Channel.OnCaptureEvent().AddRaw(this, &FRenderDocPluginNotification::OnCaptureEvent);
+}
+
+void FRenderDocPluginNotification::Ignore(FRenderDocPluginEventChannel& Channel)
 {
-	LastEnableTime = FPlatformTime::Seconds();
+	Channel.OnCaptureEvent().Remove(CaptureEventHandle);
+	if (RefreshHandle.IsValid())
+		FTicker::GetCoreTicker().RemoveTicker(RefreshHandle);
+	RefreshHandle.Reset();
+	HideNotification();
+}
 
+void FRenderDocPluginNotification::ShowNotification(const FText& Message)
+{
 	// Starting a new request! Notify the UI.
 	if (RenderDocNotificationPtr.IsValid())
 	{
@@ -62,28 +76,77 @@ void FRenderDocPluginNotification::HideNotification()
 
 	if (NotificationItem.IsValid())
 	{
-		NotificationItem->SetCompletionState(SNotificationItem::CS_Success);
+		NotificationItem->SetCompletionState((LastEvent.Stage == ERenderDocCaptureStage::Failed) ? SNotificationItem::CS_Fail : SNotificationItem::CS_Success);
 		NotificationItem->ExpireAndFadeout();
 
 		RenderDocNotificationPtr.Reset();
 	}
 }
 
-void FRenderDocPluginNotification::Tick(float DeltaTime)
+void FRenderDocPluginNotification::OnCaptureEvent(const FRenderDocPluginEvent& Event)
 {
-	double OpenTime = 5.0;
-	//if (bIsGUIOpen)
-	//	OpenTime = 0.5;
+	if (Event.Stage == ERenderDocCaptureStage::Requested)
+		CaptureStartTime = Event.Timestamp;
+	if (Event.Stage != LastEvent.Stage)
+		StageStartTime = Event.Timestamp;
+	LastEvent = Event;
+
+	if (!RenderDocNotificationPtr.IsValid())
+		ShowNotification(Describe());
+	else
+		RenderDocNotificationPtr.Pin()->SetText(Describe());
+
+	// Refresh the elapsed time a few times per second, but only until the capture
+	// is over (plus a few seconds to let the final message be read):
+	if (!RefreshHandle.IsValid())
+		RefreshHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRenderDocPluginNotification::OnRefresh), 0.25f);
+}
 
-	if (RenderDocNotificationPtr.IsValid() && (FPlatformTime::Seconds() - LastEnableTime) > OpenTime)
+bool FRenderDocPluginNotification::OnRefresh(float DeltaTime)
+{
+	if (IsDone() && (FPlatformTime::Seconds() - StageStartTime) > 3.0)
 	{
 		HideNotification();
+		RefreshHandle.Reset();
+		return(false);
 	}
+
+	if (RenderDocNotificationPtr.IsValid())
+		RenderDocNotificationPtr.Pin()->SetText(Describe());
+	return(true);
+}
+
+bool FRenderDocPluginNotification::IsDone() const
+{
+	return((LastEvent.Stage == ERenderDocCaptureStage::Finished) || (LastEvent.Stage == ERenderDocCaptureStage::Failed) || (LastEvent.Stage == ERenderDocCaptureStage::Archived));
 }
 
-TStatId FRenderDocPluginNotification::GetStatId() const
+FText FRenderDocPluginNotification::Describe() const
 {
-	RETURN_QUICK_DECLARE_CYCLE_STAT(FRenderDocPluginNotification, STATGROUP_Tickables);
+	FText Stage;
+	switch (LastEvent.Stage)
+	{
+	case ERenderDocCaptureStage::Requested: Stage = LOCTEXT("StageRequested", "Capture requested"); break;
+	case ERenderDocCaptureStage::Capturing: Stage = LOCTEXT("StageCapturing", "Capturing frame"); break;
+	case ERenderDocCaptureStage::Writing:   Stage = LOCTEXT("StageWriting",   "Writing capture"); break;
+	case ERenderDocCaptureStage::Migrating: Stage = LOCTEXT("StageMigrating", "Moving capture out of scratch"); break;
+	case ERenderDocCaptureStage::Launching: Stage = LOCTEXT("StageLaunching", "Launching RenderDoc GUI"); break;
+	case ERenderDocCaptureStage::Finished:  Stage = LOCTEXT("StageFinished",  "Capture ready"); break;
+	case ERenderDocCaptureStage::Failed:    Stage = LOCTEXT("StageFailed",    "Capture failed"); break;
+	case ERenderDocCaptureStage::Archiving: Stage = LOCTEXT("StageArchiving", "Archiving capture"); break;
+	case ERenderDocCaptureStage::Archived:  Stage = LOCTEXT("StageArchived",  "Capture archived"); break;
+	}
+
+	const double Elapsed = (IsDone() ? LastEvent.Timestamp : FPlatformTime::Seconds()) - CaptureStartTime;
+	FString Details = FString::Printf(TEXT("%.1f s"), Elapsed);
+	if (LastEvent.BytesWritten >= 0 && LastEvent.BytesTotal > 0)
+		Details += FString::Printf(TEXT(", %.1f / %.1f MB"), LastEvent.BytesWritten / (1024.0 * 1024.0), LastEvent.BytesTotal / (1024.0 * 1024.0));
+	else if (LastEvent.BytesWritten >= 0)
+		Details += FString::Printf(TEXT(", %.1f MB"), LastEvent.BytesWritten / (1024.0 * 1024.0));
+
+	return(FText::Format(LOCTEXT("StageFormat", "{0} ({1})"), Stage, FText::FromString(Details)));
 }
 
+#undef LOCTEXT_NAMESPACE
+
 #endif//WITH_EDITOR
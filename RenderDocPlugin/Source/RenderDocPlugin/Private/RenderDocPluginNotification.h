@@ -29,7 +29,15 @@
 #include "UnrealEd.h"
 #include "NotificationManager.h"
 
-class FRenderDocPluginNotification : public FTickableEditorObject
+#include "RenderDocPluginEvents.h"
+
+/**
+* Editor notification reflecting the progress of the capture in flight. It is
+* driven by the events of FRenderDocPluginEventChannel; the elapsed time is only
+* refreshed (through a core ticker) while a capture is in flight, so an idle
+* plugin costs nothing per frame.
+*/
+class FRenderDocPluginNotification
 {
 public:
 	static FRenderDocPluginNotification& Get()
@@ -38,26 +46,30 @@ public:
 		return Instance;
 	}
 
+	void Listen(FRenderDocPluginEventChannel& Channel);
+	void Ignore(FRenderDocPluginEventChannel& Channel);
+
 	void ShowNotification(const FText& Message);
 	void HideNotification();
 
-protected:
-	/** FTickableEditorObject interface */
-	virtual void Tick(float DeltaTime);
-	virtual bool IsTickable() const
-	{
-		return true;
-	}
-	virtual TStatId GetStatId() const override;
-
 private:
-	FRenderDocPluginNotification() { LastEnableTime = 0; }
+	FRenderDocPluginNotification() { StageStartTime = CaptureStartTime = 0; LastEvent.Stage = ERenderDocCaptureStage::Finished; }
 	FRenderDocPluginNotification(FRenderDocPluginNotification const&);
 	void operator=(FRenderDocPluginNotification const&);
 
-	double LastEnableTime;
+	void OnCaptureEvent(const FRenderDocPluginEvent& Event);
+	bool OnRefresh(float DeltaTime);
+	bool IsDone() const;
+	FText Describe() const;
+
+	FRenderDocPluginEvent LastEvent;
+	double StageStartTime;
+	double CaptureStartTime;
+
+	FDelegateHandle CaptureEventHandle;
+	FDelegateHandle RefreshHandle;
 
-	/** The source code symbol query in progress message */
+	/** The capture in progress message */
 	TWeakPtr<SNotificationItem> RenderDocNotificationPtr;
 };
 
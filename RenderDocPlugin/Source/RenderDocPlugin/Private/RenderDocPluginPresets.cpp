@@ -0,0 +1,135 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginPresets.h"
+
+static const TCHAR* PresetStatsSection = TEXT("RenderDoc.PresetStats");
+
+static void ApplyMinimalOverhead(FRenderDocPluginSettings& Settings)
+{
+	Settings.bCaptureCallStacks          = false;
+	Settings.bCaptureCallStacksOnlyDraws = false;
+	Settings.bRefAllResources            = false;
+	Settings.bSaveAllInitials            = false;
+	Settings.bCaptureAllCmdLists         = false;
+	Settings.bVerifyMapWrites            = false;
+	Settings.bAPIValidation              = false;
+	Settings.DelayForDebugger            = 0;
+}
+
+static void ApplyCallstacksOnDraws(FRenderDocPluginSettings& Settings)
+{
+	ApplyMinimalOverhead(Settings);
+	Settings.bCaptureCallStacks          = true;
+	Settings.bCaptureCallStacksOnlyDraws = true;
+}
+
+static void ApplyFullFidelity(FRenderDocPluginSettings& Settings)
+{
+	Settings.bCaptureCallStacks          = true;
+	Settings.bCaptureCallStacksOnlyDraws = false;
+	Settings.bRefAllResources            = true;
+	Settings.bSaveAllInitials            = true;
+	Settings.bCaptureAllCmdLists         = true;
+	Settings.bVerifyMapWrites            = true;
+	Settings.bAPIValidation              = true;
+	Settings.DelayForDebugger            = 0;
+}
+
+const TArray<FRenderDocPluginPreset>& FRenderDocPluginPresets::Get()
+{
+	static TArray<FRenderDocPluginPreset> Presets;
+	if (Presets.Num() == 0)
+	{
+		Presets.Add({ TEXT("MinimalOverhead"),   TEXT("Minimal Overhead"),
+			TEXT("Only what is referenced by the frame; no call stacks, no validation."), &ApplyMinimalOverhead });
+		Presets.Add({ TEXT("CallstacksOnDraws"), TEXT("Callstacks On Draws Only"),
+			TEXT("Minimal overhead, plus a call stack for every draw call (but not for state changes)."), &ApplyCallstacksOnDraws });
+		Presets.Add({ TEXT("FullFidelity"),      TEXT("Full Fidelity"),
+			TEXT("All resources and initial states, all command lists, call stacks, map write verification and API validation."), &ApplyFullFidelity });
+	}
+	return(Presets);
+}
+
+const FRenderDocPluginPreset* FRenderDocPluginPresets::Find(const FString& Name)
+{
+	for (const FRenderDocPluginPreset& Preset : Get())
+		if (Name == Preset.Name)
+			return(&Preset);
+	return(nullptr);
+}
+
+bool FRenderDocPluginPresets::Apply(const FString& Name, FRenderDocPluginSettings& Settings)
+{
+	const FRenderDocPluginPreset* Preset = Find(Name);
+	if (!Preset)
+		return(false);
+	Preset->Apply(Settings);
+	Settings.Preset = Preset->Name;
+	return(true);
+}
+
+FRenderDocPluginPresets::FStats FRenderDocPluginPresets::LoadStats(const FString& Name)
+{
+	FStats Stats = { 0, 0.0, 0 };
+	if (!GConfig)
+		return(Stats);
+
+	FString TotalBytes;
+	GConfig->GetInt   (PresetStatsSection, *(Name + TEXT(".Captures")),     Stats.NumCaptures,  GGameIni);
+	GConfig->GetDouble(PresetStatsSection, *(Name + TEXT(".TotalSeconds")), Stats.TotalSeconds, GGameIni);
+	if (GConfig->GetString(PresetStatsSection, *(Name + TEXT(".TotalBytes")), TotalBytes, GGameIni))
+		Stats.TotalBytes = FCString::Atoi64(*TotalBytes);
+	return(Stats);
+}
+
+void FRenderDocPluginPresets::RecordCapture(const FString& Name, double Seconds, int64 Bytes)
+{
+	if (!GConfig)
+		return;
+
+	FStats Stats = LoadStats(Name);
+	Stats.NumCaptures  += 1;
+	Stats.TotalSeconds += Seconds;
+	Stats.TotalBytes   += Bytes;
+
+	GConfig->SetInt   (PresetStatsSection, *(Name + TEXT(".Captures")),     Stats.NumCaptures,  GGameIni);
+	GConfig->SetDouble(PresetStatsSection, *(Name + TEXT(".TotalSeconds")), Stats.TotalSeconds, GGameIni);
+	GConfig->SetString(PresetStatsSection, *(Name + TEXT(".TotalBytes")),   *FString::Printf(TEXT("%lld"), Stats.TotalBytes), GGameIni);
+	GConfig->Flush(false, GGameIni);
+}
+
+FString FRenderDocPluginPresets::DescribeStats(const FString& Name)
+{
+	const FStats Stats = LoadStats(Name);
+	if (Stats.NumCaptures == 0)
+		return(TEXT("not measured yet"));
+
+	return(FString::Printf(TEXT("avg %.0f ms, %.1f MB (%d captures)"),
+		1000.0 * Stats.TotalSeconds / Stats.NumCaptures,
+		(double)Stats.TotalBytes / (1024.0 * 1024.0 * Stats.NumCaptures),
+		Stats.NumCaptures));
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#include "RenderDocPluginSettings.h"
+
+/**
+* Named capture option presets. Each preset overwrites the RenderDoc capture
+* options of FRenderDocPluginSettings; the cost of every capture taken (capture
+* latency and capture file size) is accumulated per preset in the game config
+* so that presets can be compared on measured numbers.
+*/
+struct FRenderDocPluginPreset
+{
+	const TCHAR* Name;
+	const TCHAR* Label;
+	const TCHAR* Description;
+	void (*Apply)(FRenderDocPluginSettings& Settings);
+};
+
+class FRenderDocPluginPresets
+{
+public:
+	struct FStats
+	{
+		int32  NumCaptures;
+		double TotalSeconds;
+		int64  TotalBytes;
+	};
+
+	static const TArray<FRenderDocPluginPreset>& Get();
+	static const FRenderDocPluginPreset* Find(const FString& Name);
+
+	/** Applies the named preset to the settings; returns false if there is no such preset. */
+	static bool Apply(const FString& Name, FRenderDocPluginSettings& Settings);
+
+	static FStats LoadStats(const FString& Name);
+	static void RecordCapture(const FString& Name, double Seconds, int64 Bytes);
+
+	/** Human readable summary of the measured costs, e.g. "avg 310 ms, 84.2 MB (5 captures)". */
+	static FString DescribeStats(const FString& Name);
+};
@@ -0,0 +1,147 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginSequenceCapture.h"
+
+#if RENDERDOC_PLUGIN_SEQUENCER
+
+#include "RenderDocPluginModule.h"
+
+#include "LevelSequenceActor.h"
+#include "MovieScene.h"
+#include "Tracks/MovieSceneCinematicShotTrack.h"
+#include "Sections/MovieSceneCinematicShotSection.h"
+
+static float ResolveFrameRate(float FrameRate)
+{
+	if (FrameRate > 0.0f)
+		return(FrameRate);
+	if (FApp::UseFixedTimeStep() && FApp::GetFixedDeltaTime() > 0.0)
+		return((float)(1.0 / FApp::GetFixedDeltaTime()));
+	return(30.0f);
+}
+
+static FString FindShotName(ULevelSequence* Sequence, float Time)
+{
+	UMovieScene* MovieScene = Sequence->GetMovieScene();
+	UMovieSceneCinematicShotTrack* ShotTrack = MovieScene ? MovieScene->FindMasterTrack<UMovieSceneCinematicShotTrack>() : NULL;
+	if (!ShotTrack)
+		return(FString());
+
+	for (UMovieSceneSection* Section : ShotTrack->GetAllSections())
+	{
+		UMovieSceneCinematicShotSection* Shot = Cast<UMovieSceneCinematicShotSection>(Section);
+		if (Shot && Shot->IsTimeWithinSection(Time))
+			return(Shot->GetShotDisplayName());
+	}
+	return(FString());
+}
+
+void FRenderDocPluginSequenceCapture::Schedule(const FString& Sequence, int32 Frame, float FrameRate)
+{
+	FRequest Request;
+	Request.Sequence = Sequence;
+	Request.Frame = Frame;
+	Request.FrameRate = FrameRate;
+	Request.LastTime = 0.0f;
+	Requests.Add(Request);
+	UE_LOG(RenderDocPlugin, Log, TEXT("frame %d of sequence '%s' scheduled for capture"), Frame, *Sequence);
+}
+
+void FRenderDocPluginSequenceCapture::ListScheduledFrames() const
+{
+	for (const FRequest& Request : Requests)
+		UE_LOG(RenderDocPlugin, Display, TEXT("%s frame %d (%.2f fps)"), *Request.Sequence, Request.Frame, ResolveFrameRate(Request.FrameRate));
+}
+
+bool FRenderDocPluginSequenceCapture::Tick(FString& OutLabel)
+{
+	if (Requests.Num() == 0)
+		return(false);
+
+	// Time step the sequences are about to be advanced by, during this tick:
+	const float DeltaTime = FApp::UseFixedTimeStep() ? (float)FApp::GetFixedDeltaTime() : (float)FApp::GetDeltaTime();
+	int32 CaptureIndex = INDEX_NONE;
+
+	for (TObjectIterator<ALevelSequenceActor> It; It; ++It)
+	{
+		ALevelSequenceActor* Actor = *It;
+		ULevelSequencePlayer* Player = Actor->SequencePlayer;
+		UWorld* World = Actor->GetWorld();
+		if (!Player || !Player->IsPlaying() || !World || !World->IsGameWorld())
+			continue;
+
+		ULevelSequence* Sequence = Actor->GetSequence();
+		if (!Sequence)
+			continue;
+
+		const FString SequenceName = Sequence->GetName();
+		// The position evaluated during the previous tick, and the one about to be:
+		const float Position = Player->GetPlaybackPosition();
+		const float PlayRate = Player->GetPlayRate();
+		const float Time = Position + DeltaTime * PlayRate;
+
+		// Every request of the sequence is updated, even once a capture is due:
+		for (int32 i = 0; i < Requests.Num(); ++i)
+		{
+			FRequest& Request = Requests[i];
+			if (Request.Sequence != SequenceName)
+				continue;
+
+			const float FrameRate = ResolveFrameRate(Request.FrameRate);
+			const int32 Frame = FMath::RoundToInt(Time * FrameRate);
+			const int32 LastFrame = FMath::RoundToInt(Request.LastTime * FrameRate);
+			// Playback went on from where it was predicted to be; a seek or a loop
+			// moves it elsewhere, and a request seen for the first time has no past:
+			const bool bContinuous = (Request.LastPlayer.Get() == Player) && FMath::Abs(Position - Request.LastTime) <= 1.0f / FrameRate;
+			Request.LastPlayer = Player;
+			Request.LastTime = Time;
+
+			bool bReached = (Frame == Request.Frame);
+			if (!bReached && bContinuous)
+				bReached = (PlayRate >= 0.0f) ? (LastFrame < Request.Frame && Request.Frame < Frame) : (Frame < Request.Frame && Request.Frame < LastFrame);
+			if (!bReached || CaptureIndex != INDEX_NONE)
+				continue;
+			if (Frame != Request.Frame)
+				UE_LOG(RenderDocPlugin, Warning, TEXT("sequence '%s' skipped over frame %d; capturing frame %d instead"), *SequenceName, Request.Frame, Frame);
+
+			const FString ShotName = FindShotName(Sequence, Time);
+			OutLabel = ShotName.IsEmpty()
+				? FString::Printf(TEXT("%s_%d"), *SequenceName, Frame)
+				: FString::Printf(TEXT("%s_%s_%d"), *SequenceName, *ShotName, Frame);
+			CaptureIndex = i;
+		}
+	}
+
+	if (CaptureIndex == INDEX_NONE)
+		return(false);
+
+	UE_LOG(RenderDocPlugin, Log, TEXT("capturing sequence frame %s"), *OutLabel);
+	Requests.RemoveAt(CaptureIndex);
+	return(true);
+}
+
+#endif//RENDERDOC_PLUGIN_SEQUENCER
@@ -0,0 +1,86 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+// Sequencer frame captures; RenderDocPlugin.Build.cs leaves them out (along with the
+// LevelSequence and MovieScene dependencies) of Shipping builds and dedicated servers:
+#ifndef RENDERDOC_PLUGIN_SEQUENCER
+#define RENDERDOC_PLUGIN_SEQUENCER !UE_BUILD_SHIPPING
+#endif
+
+#if RENDERDOC_PLUGIN_SEQUENCER
+
+/**
+* Captures specific frames of Sequencer cinematics, by sequence name and frame
+* number, regardless of what happens to be on screen when the capture is asked
+* for. At the start of every engine tick, the playback position each playing
+* level sequence will evaluate during that tick is predicted from its current
+* position, play rate and the tick's time step; when it lands on a scheduled
+* frame, the whole engine tick (evaluation and rendering) is captured.
+*
+* Predictions are exact with a fixed time step, which is what movie scene captures
+* (-MovieSceneCaptureType, "Render Movie") use; with a variable time step, a
+* scheduled frame that gets skipped over is captured at the first frame after it.
+* Only playback reaching the frame counts, forwards or backwards: a sequence that
+* is already past it, or that jumps over it (seek, loop), is waited for until it
+* plays the frame again. Captures are labeled "<sequence>_<shot>_<frame>".
+*/
+class FRenderDocPluginSequenceCapture
+{
+public:
+	/**
+	* Schedules the capture of a frame of a level sequence (asset name).
+	* @param FrameRate Frame rate the frame number refers to; 0 for the fixed frame
+	*                  rate of the engine, or 30 without one.
+	*/
+	void Schedule(const FString& Sequence, int32 Frame, float FrameRate);
+
+	bool HasScheduledFrames() const { return(Requests.Num() > 0); }
+	void ListScheduledFrames() const;
+
+	/**
+	* To be called at the start of every engine tick, on the game thread. Returns
+	* true (and the capture label) if this tick evaluates a scheduled frame.
+	*/
+	bool Tick(FString& OutLabel);
+
+private:
+	struct FRequest
+	{
+		FString Sequence;
+		int32 Frame;
+		float FrameRate;
+
+		// Player and playback position of the sequence predicted for the previous
+		// tick, to tell playback through Frame from a jump over it:
+		TWeakObjectPtr<class ULevelSequencePlayer> LastPlayer;
+		float LastTime;
+	};
+
+	TArray<FRequest> Requests;
+};
+
+#endif//RENDERDOC_PLUGIN_SEQUENCER
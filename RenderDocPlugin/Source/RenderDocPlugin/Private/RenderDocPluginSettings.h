@@ -31,10 +31,36 @@ public:
 	bool bCaptureCallStacks;
 	bool bRefAllResources;
 	bool bSaveAllInitials;
+	bool bUseCaptureStore;
+	bool bDeferredViewportCapture;
+
+	// Remaining RENDERDOC_CaptureOption values; note that AllowVSync and
+	// APIValidation only take effect for devices created after they are set.
+	bool bCaptureCallStacksOnlyDraws;
+	bool bCaptureAllCmdLists;
+	bool bVerifyMapWrites;
+	bool bAPIValidation;
+	bool bAllowVSync;
+	int32 DelayForDebugger;
+
+	// Fast local directory (NVMe, RAM disk) RenderDoc writes captures into before
+	// they are migrated to Saved/RenderDocCaptures; empty to write there directly:
+	FString ScratchDirectory;
+
+	// Safety caps of range captures (RenderDoc.BeginRange/EndRange): maximum number
+	// of frames, and maximum growth of the process memory (MB) while recording:
+	int32 RangeCaptureMaxFrames;
+	int32 RangeCaptureMaxMB;
+
+	// Name of the capture preset the options above came from ("Custom" once edited):
+	FString Preset;
+
+	// Open finished captures in the RenderDoc GUI; never done by windowless processes:
+	bool bLaunchReplayUI;
 
 	FRenderDocPluginSettings()
 	{
-		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("CaptureAllActivity"), bCaptureCallStacks, GGameIni))
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("CaptureAllActivity"), bCaptureAllActivity, GGameIni))
 			bCaptureAllActivity = false;
 
 		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("CaptureCallStacks"), bCaptureCallStacks, GGameIni))
@@ -45,6 +71,45 @@ public:
 
 		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("SaveAllInitials"), bSaveAllInitials, GGameIni))
 			bSaveAllInitials = false;
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("UseCaptureStore"), bUseCaptureStore, GGameIni))
+			bUseCaptureStore = false;
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("DeferredViewportCapture"), bDeferredViewportCapture, GGameIni))
+			bDeferredViewportCapture = false;
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("CaptureCallStacksOnlyDraws"), bCaptureCallStacksOnlyDraws, GGameIni))
+			bCaptureCallStacksOnlyDraws = false;
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("CaptureAllCmdLists"), bCaptureAllCmdLists, GGameIni))
+			bCaptureAllCmdLists = false;
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("VerifyMapWrites"), bVerifyMapWrites, GGameIni))
+			bVerifyMapWrites = false;
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("APIValidation"), bAPIValidation, GGameIni))
+			bAPIValidation = false;
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("AllowVSync"), bAllowVSync, GGameIni))
+			bAllowVSync = true;
+
+		if (!GConfig->GetInt(TEXT("RenderDoc"), TEXT("DelayForDebugger"), DelayForDebugger, GGameIni))
+			DelayForDebugger = 0;
+
+		if (!GConfig->GetString(TEXT("RenderDoc"), TEXT("ScratchDirectory"), ScratchDirectory, GGameIni))
+			ScratchDirectory.Empty();
+
+		if (!GConfig->GetInt(TEXT("RenderDoc"), TEXT("RangeCaptureMaxFrames"), RangeCaptureMaxFrames, GGameIni))
+			RangeCaptureMaxFrames = 600;
+
+		if (!GConfig->GetInt(TEXT("RenderDoc"), TEXT("RangeCaptureMaxMB"), RangeCaptureMaxMB, GGameIni))
+			RangeCaptureMaxMB = 4096;
+
+		if (!GConfig->GetString(TEXT("RenderDoc"), TEXT("Preset"), Preset, GGameIni))
+			Preset = TEXT("Custom");
+
+		if (!GConfig->GetBool(TEXT("RenderDoc"), TEXT("LaunchReplayUI"), bLaunchReplayUI, GGameIni))
+			bLaunchReplayUI = true;
 	}
 
 	void Save() const
@@ -53,6 +118,19 @@ public:
 		GConfig->SetBool(TEXT("RenderDoc"), TEXT("CaptureCallStacks"),  bCaptureCallStacks,  GGameIni);
 		GConfig->SetBool(TEXT("RenderDoc"), TEXT("RefAllResources"),    bRefAllResources,    GGameIni);
 		GConfig->SetBool(TEXT("RenderDoc"), TEXT("SaveAllInitials"),    bSaveAllInitials,    GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("UseCaptureStore"),    bUseCaptureStore,    GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("DeferredViewportCapture"), bDeferredViewportCapture, GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("CaptureCallStacksOnlyDraws"), bCaptureCallStacksOnlyDraws, GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("CaptureAllCmdLists"), bCaptureAllCmdLists, GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("VerifyMapWrites"),    bVerifyMapWrites,    GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("APIValidation"),      bAPIValidation,      GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("AllowVSync"),         bAllowVSync,         GGameIni);
+		GConfig->SetInt (TEXT("RenderDoc"), TEXT("DelayForDebugger"),   DelayForDebugger,    GGameIni);
+		GConfig->SetString(TEXT("RenderDoc"), TEXT("ScratchDirectory"), *ScratchDirectory,   GGameIni);
+		GConfig->SetInt (TEXT("RenderDoc"), TEXT("RangeCaptureMaxFrames"), RangeCaptureMaxFrames, GGameIni);
+		GConfig->SetInt (TEXT("RenderDoc"), TEXT("RangeCaptureMaxMB"), RangeCaptureMaxMB,  GGameIni);
+		GConfig->SetString(TEXT("RenderDoc"), TEXT("Preset"),           *Preset,             GGameIni);
+		GConfig->SetBool(TEXT("RenderDoc"), TEXT("LaunchReplayUI"),     bLaunchReplayUI,     GGameIni);
 		GConfig->Flush(false, GGameIni);
 	}
 };
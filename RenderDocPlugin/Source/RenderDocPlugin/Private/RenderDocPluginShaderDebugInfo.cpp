@@ -0,0 +1,150 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#if WITH_EDITOR
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginShaderDebugInfo.h"
+
+#include "RenderDocPluginModule.h"
+
+FRenderDocPluginShaderDebugInfo::FRenderDocPluginShaderDebugInfo()
+	: bEnabled(false)
+{
+	if (GConfig)
+		GConfig->GetBool(TEXT("RenderDoc"), TEXT("RecompileCapturedShaders"), bEnabled, GGameIni);
+}
+
+void FRenderDocPluginShaderDebugInfo::SetEnabled(bool bInEnabled)
+{
+	bEnabled = bInEnabled;
+	if (bEnabled)
+		return;
+
+	// Forget the materials that were queued but not recompiled yet:
+	for (const TWeakObjectPtr<UMaterial>& Material : Pending)
+		if (Material.IsValid())
+			Known.Remove(FName(*Material->GetPathName()));
+	Pending.Empty();
+	RestoreDebugInfo();
+}
+
+void FRenderDocPluginShaderDebugInfo::CollectRenderedMaterials()
+{
+	if (!bEnabled)
+		return;
+
+	const int32 PendingBefore = Pending.Num();
+	TArray<UMaterialInterface*> UsedMaterials;
+	for (TObjectIterator<UPrimitiveComponent> It; It; ++It)
+	{
+		UPrimitiveComponent* Component = *It;
+		UWorld* World = Component->GetWorld();
+		if (!World || !Component->IsRegistered())
+			continue;
+
+		// LastRenderTime is stamped by the renderer with the world clock:
+		const float Tolerance = FMath::Max(0.1f, 2.0f * World->GetDeltaSeconds());
+		if (World->GetTimeSeconds() - Component->LastRenderTime > Tolerance)
+			continue;
+
+		UsedMaterials.Reset();
+		Component->GetUsedMaterials(UsedMaterials);
+		for (UMaterialInterface* MaterialInterface : UsedMaterials)
+		{
+			// Material instances without static parameters share the shader map of
+			// their base material, which is therefore the one to recompile:
+			UMaterial* Material = MaterialInterface ? MaterialInterface->GetMaterial() : NULL;
+			if (!Material)
+				continue;
+
+			bool bAlreadyKnown (false);
+			Known.Add(FName(*Material->GetPathName()), &bAlreadyKnown);
+			if (!bAlreadyKnown)
+				Pending.Add(Material);
+		}
+	}
+
+	if (Pending.Num() > PendingBefore)
+		UE_LOG(RenderDocPlugin, Log, TEXT("%d captured material(s) queued for recompilation with shader debug info"), Pending.Num() - PendingBefore);
+}
+
+void FRenderDocPluginShaderDebugInfo::Tick()
+{
+	if (Pending.Num() == 0)
+		return;
+
+	UMaterial* Material = Pending[0].Get();
+	Pending.RemoveAt(0, 1, false);
+	if (Material)
+	{
+		EnableDebugInfo();
+
+		UE_LOG(RenderDocPlugin, Log, TEXT("recompiling '%s' with shader debug info (%d left)"), *Material->GetPathName(), Pending.Num());
+		Material->ForceRecompileForRendering();
+	}
+
+	// The compile jobs read the console variables when they are created, so the
+	// shaders compiled from now on are left alone:
+	if (Pending.Num() == 0)
+		RestoreDebugInfo();
+}
+
+void FRenderDocPluginShaderDebugInfo::EnableDebugInfo()
+{
+	if (SavedVariables.Num() > 0)
+		return;
+
+	OverrideVariable(TEXT("r.Shaders.Optimize"), 0);
+	OverrideVariable(TEXT("r.Shaders.KeepDebugInfo"), 1);
+}
+
+void FRenderDocPluginShaderDebugInfo::OverrideVariable(const TCHAR* Name, int32 Value)
+{
+	// Not every variable is available in every engine version:
+	IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(Name);
+	if (!Variable)
+		return;
+
+	FSavedVariable& Saved = SavedVariables[SavedVariables.AddDefaulted()];
+	Saved.Variable = Variable;
+	Saved.Value = Variable->GetString();
+	Saved.SetBy = (EConsoleVariableFlags)(Variable->GetFlags() & ECVF_SetByMask);
+	Variable->Set(Value);
+}
+
+void FRenderDocPluginShaderDebugInfo::RestoreDebugInfo()
+{
+	// A console variable refuses values set with a lower priority than its last
+	// one, so it drops back to the lowest first:
+	for (const FSavedVariable& Saved : SavedVariables)
+	{
+		Saved.Variable->ClearFlags(ECVF_SetByMask);
+		Saved.Variable->Set(*Saved.Value, Saved.SetBy);
+	}
+	SavedVariables.Empty();
+}
+
+#endif//WITH_EDITOR
@@ -0,0 +1,87 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#if WITH_EDITOR
+
+/**
+* Gives captures readable shader source without recompiling the whole project
+* with debug info: while enabled, the materials of the primitives rendered in a
+* captured frame are queued and recompiled, one per tick, with optimizations
+* disabled and debug info kept (r.Shaders.Optimize=0, r.Shaders.KeepDebugInfo=1).
+* Materials that have already been recompiled are remembered for the rest of the
+* session, so the next capture of the same scene shows shader source right away;
+* the derived data cache keeps the unoptimized shader maps across sessions, which
+* makes recompiling them again in a later session cheap.
+*
+*   [RenderDoc]
+*   RecompileCapturedShaders=True
+*
+* The console variables affect every shader compiled while they are set, so they
+* are only changed while queued materials are being recompiled; their values and
+* priorities are restored once the queue drains, or the feature is disabled.
+*/
+class FRenderDocPluginShaderDebugInfo
+{
+public:
+	FRenderDocPluginShaderDebugInfo();
+
+	bool IsEnabled() const { return(bEnabled); }
+	void SetEnabled(bool bInEnabled);
+
+	/**
+	* Queues the materials of the primitives rendered during the last frame that do
+	* not have debug info yet. Game thread only.
+	*/
+	void CollectRenderedMaterials();
+
+	/**
+	* Recompiles at most one queued material. Game thread only; to be called once per
+	* tick while no capture is being recorded.
+	*/
+	void Tick();
+
+private:
+	void EnableDebugInfo();
+	void RestoreDebugInfo();
+	void OverrideVariable(const TCHAR* Name, int32 Value);
+
+	struct FSavedVariable
+	{
+		IConsoleVariable* Variable;
+		FString Value;
+		EConsoleVariableFlags SetBy;
+	};
+
+	bool bEnabled;
+	// Console variables overridden while recompiling, with their previous state:
+	TArray<FSavedVariable> SavedVariables;
+	TArray< TWeakObjectPtr<UMaterial> > Pending;
+	// Materials queued or already recompiled during this session:
+	TSet<FName> Known;
+};
+
+#endif//WITH_EDITOR
@@ -0,0 +1,158 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#include "RenderDocPluginPrivatePCH.h"
+#include "RenderDocPluginStatTriggers.h"
+
+#include "RenderDocPluginModule.h"
+
+static const TCHAR* StatNames [] = { TEXT("DrawCalls"), TEXT("Primitives"), TEXT("TextureMemoryMB"), TEXT("RenderTargetMemoryMB") };
+
+FRenderDocPluginStatTriggers::FRenderDocPluginStatTriggers()
+	: MatchedRule(INDEX_NONE)
+	, bEnabled(false)
+	, Cooldown(30.0)
+	, LastTriggerTime(-DBL_MAX)
+	, BaselineFrames(120)
+	, NumBaselineSamples(0)
+{
+	FMemory::Memzero(Baseline);
+
+	if (!GConfig)
+		return;
+
+	GConfig->GetBool  (TEXT("RenderDoc"), TEXT("StatTriggersEnabled"),       bEnabled,       GGameIni);
+	GConfig->GetDouble(TEXT("RenderDoc"), TEXT("StatTriggerCooldown"),       Cooldown,       GGameIni);
+	GConfig->GetInt   (TEXT("RenderDoc"), TEXT("StatTriggerBaselineFrames"), BaselineFrames, GGameIni);
+	BaselineFrames = FMath::Max(1, BaselineFrames);
+
+	TArray<FString> RuleTexts;
+	GConfig->GetArray(TEXT("RenderDoc"), TEXT("StatTrigger"), RuleTexts, GGameIni);
+	for (const FString& RuleText : RuleTexts)
+	{
+		FRule Rule;
+		if (ParseRule(RuleText, Rule))
+			Rules.Add(Rule);
+		else
+			UE_LOG(RenderDocPlugin, Warning, TEXT("ignoring malformed stat trigger '%s'"), *RuleText);
+	}
+}
+
+bool FRenderDocPluginStatTriggers::ParseRule(const FString& Text, FRule& OutRule) const
+{
+	TArray<FString> Tokens;
+	Text.ParseIntoArrayWS(Tokens);
+	if (Tokens.Num() != 3 || (Tokens[1] != TEXT(">") && Tokens[1] != TEXT("x")))
+		return(false);
+
+	int32 Stat = 0;
+	while (Stat < NumStats && Tokens[0] != StatNames[Stat])
+		++Stat;
+	if (Stat == NumStats)
+		return(false);
+
+	OutRule.Stat = (EStat)Stat;
+	OutRule.bRelative = (Tokens[1] == TEXT("x"));
+	OutRule.Threshold = FCString::Atod(*Tokens[2]);
+	OutRule.bLatched = false;
+	OutRule.Description = FString::Printf(TEXT("%s %s %s"), *Tokens[0], *Tokens[1], *Tokens[2]);
+	return(OutRule.Threshold > 0.0);
+}
+
+void FRenderDocPluginStatTriggers::SetEnabled(bool bInEnabled)
+{
+	bEnabled = bInEnabled;
+	NumBaselineSamples = 0;
+	MatchedRule = INDEX_NONE;
+	Sampler.Reset();
+	for (FRule& Rule : Rules)
+		Rule.bLatched = false;
+}
+
+bool FRenderDocPluginStatTriggers::Tick(FString& OutReason)
+{
+	if (!bEnabled || Rules.Num() == 0)
+		return(false);
+
+	Sampler.RequestSample();
+
+	// Every frame sampled since the last tick (none if the rendering side lags
+	// behind) goes through the rules and into the baseline:
+	MatchedRule = INDEX_NONE;
+	bool bTriggered (false);
+	FRenderDocFrameStats Stats;
+	while (Sampler.Dequeue(Stats))
+	{
+		const double Values [NumStats] = { (double)Stats.DrawCalls, (double)Stats.Primitives, (double)Stats.TextureMemoryMB, (double)Stats.RenderTargetMemoryMB };
+		bTriggered |= Evaluate(Values, OutReason);
+	}
+	return(bTriggered);
+}
+
+void FRenderDocPluginStatTriggers::OnCaptureArmed()
+{
+	if (!Rules.IsValidIndex(MatchedRule))
+		return;
+
+	Rules[MatchedRule].bLatched = true;
+	MatchedRule = INDEX_NONE;
+	LastTriggerTime = FPlatformTime::Seconds();
+}
+
+bool FRenderDocPluginStatTriggers::Evaluate(const double* Values, FString& OutReason)
+{
+	// A matching rule is left unlatched until the capture is armed, so that a spike
+	// met while another capture is in progress (or refused) is tried again:
+	bool bTriggered (false);
+	const bool bBaselineReady = (NumBaselineSamples >= BaselineFrames);
+	const bool bCoolingDown = (FPlatformTime::Seconds() - LastTriggerTime) < Cooldown;
+	for (int32 i = 0; i < Rules.Num(); ++i)
+	{
+		FRule& Rule = Rules[i];
+		const double Threshold = Rule.bRelative ? Rule.Threshold * Baseline[Rule.Stat] : Rule.Threshold;
+		const bool bMatch = (Values[Rule.Stat] > Threshold) && (!Rule.bRelative || bBaselineReady);
+
+		if (!bMatch)
+		{
+			Rule.bLatched = false;
+			continue;
+		}
+
+		if (Rule.bLatched || bCoolingDown || bTriggered)
+			continue;
+
+		MatchedRule = i;
+		bTriggered = true;
+		OutReason = FString::Printf(TEXT("%s (%s = %.0f, baseline %.0f)"), *Rule.Description, StatNames[Rule.Stat], Values[Rule.Stat], Baseline[Rule.Stat]);
+	}
+
+	// Update the rolling baseline (a plain average until enough samples are in):
+	++NumBaselineSamples;
+	const double Alpha = 1.0 / FMath::Min(NumBaselineSamples, BaselineFrames);
+	for (int32 i = 0; i < NumStats; ++i)
+		Baseline[i] += (Values[i] - Baseline[i]) * Alpha;
+
+	return(bTriggered);
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2014-2016 Fredrik Lindh
+*                         Marcos Slomp
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+******************************************************************************/
+
+#pragma once
+
+#include "RenderDocPluginFrameStats.h"
+
+/**
+* Arms captures automatically when render statistics cross configurable
+* thresholds, so that frames with draw call, primitive or RHI memory spikes get
+* recorded without anyone watching. Rules are read from the game config:
+*
+*   [RenderDoc]
+*   StatTriggersEnabled=True
+*   StatTriggerCooldown=30          ; seconds between two triggered captures
+*   StatTriggerBaselineFrames=120   ; length of the rolling baseline
+*   +StatTrigger=DrawCalls > 5000   ; absolute threshold
+*   +StatTrigger=Primitives x 1.5   ; relative to the rolling baseline
+*
+* Known statistics: DrawCalls, Primitives, TextureMemoryMB, RenderTargetMemoryMB.
+* A rule that fired stays latched until its condition stops holding, so a single
+* sustained spike produces a single capture. Rules only latch, and the cooldown
+* only starts, once the capture has actually been armed (see OnCaptureArmed).
+*/
+class FRenderDocPluginStatTriggers
+{
+public:
+	FRenderDocPluginStatTriggers();
+
+	bool IsEnabled() const { return(bEnabled); }
+	void SetEnabled(bool bInEnabled);
+
+	/**
+	* To be called once per engine tick, on the game thread. Returns true (and a
+	* description of the rule that matched) when a capture should be armed.
+	*/
+	bool Tick(FString& OutReason);
+
+	/** The capture asked for by Tick() has been armed; latches its rule. */
+	void OnCaptureArmed();
+
+private:
+	enum EStat { DrawCalls, Primitives, TextureMemoryMB, RenderTargetMemoryMB, NumStats };
+
+	struct FRule
+	{
+		EStat Stat;
+		bool bRelative;
+		double Threshold;
+		bool bLatched;
+		FString Description;
+	};
+
+	bool ParseRule(const FString& Text, FRule& OutRule) const;
+	bool Evaluate(const double* Values, FString& OutReason);
+
+	TArray<FRule> Rules;
+	int32 MatchedRule;
+	bool bEnabled;
+	double Cooldown;
+	double LastTriggerTime;
+	int32 BaselineFrames;
+
+	// Rolling (exponential moving average) baseline of every statistic:
+	double Baseline [NumStats];
+	int32 NumBaselineSamples;
+
+	FRenderDocPluginFrameStatsSampler Sampler;
+};
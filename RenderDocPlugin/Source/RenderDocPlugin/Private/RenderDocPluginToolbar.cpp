@@ -36,6 +36,7 @@
 #include "RenderDocPluginCommands.h"
 #include "RenderDocPluginModule.h"
 #include "RenderDocPluginAboutWindow.h"
+#include "RenderDocPluginPresets.h"
 
 FRenderDocPluginEditorExtension::FRenderDocPluginEditorExtension(FRenderDocPluginModule* ThePlugin, FRenderDocPluginSettings* Settings)
 {
@@ -243,15 +244,96 @@ void SRenderDocPluginToolbar::Construct(const FArguments& InArgs)
 			]
 			.MenuContent()
 			[        
-				([this,RenderDocSettings]() -> TSharedRef<SWidget>
+				([this,ThePlugin,RenderDocSettings]() -> TSharedRef<SWidget>
 				{
 					auto& Commands = FRenderDocPluginCommands::Get();
 					FMenuBuilder ShowMenuBuilder (true, CommandList);
 
 					ShowMenuBuilder.AddMenuEntry(Commands.Settings_CaptureAllActivity);
+					ShowMenuBuilder.AddMenuEntry(Commands.Settings_DeferredViewportCapture);
 					ShowMenuBuilder.AddMenuEntry(Commands.Settings_CaptureCallstack);
 					ShowMenuBuilder.AddMenuEntry(Commands.Settings_CaptureAllResources);
 					ShowMenuBuilder.AddMenuEntry(Commands.Settings_SaveAllInitialState);
+					ShowMenuBuilder.AddMenuEntry(Commands.Settings_UseCaptureStore);
+
+					// Filled when opened, since PIE sessions come and go:
+					ShowMenuBuilder.AddSubMenu(
+						LOCTEXT("CaptureWorld", "Capture PIE Instance"),
+						LOCTEXT("CaptureWorld_ToolTip", "Capture the next frame of a single Play-In-Editor client or server, leaving the other instances out of the capture."),
+						FNewMenuDelegate::CreateLambda([ThePlugin](FMenuBuilder& SubMenuBuilder)
+						{
+							bool bAnyWorld (false);
+							for (const FWorldContext& Context : GEngine->GetWorldContexts())
+							{
+								if (Context.WorldType != EWorldType::PIE || !Context.GameViewport)
+									continue;
+								const int32 PIEInstance = Context.PIEInstance;
+								SubMenuBuilder.AddMenuEntry(
+									FText::FromString(FRenderDocPluginModule::DescribeWorld(Context)),
+									FText(),
+									FSlateIcon(),
+									FUIAction(FExecuteAction::CreateLambda([ThePlugin, PIEInstance]() { ThePlugin->CaptureWorld(PIEInstance); }))
+								);
+								bAnyWorld = true;
+							}
+							if (!bAnyWorld)
+								SubMenuBuilder.AddWidget(SNew(STextBlock).Text(LOCTEXT("NoPIEWorld", "No Play-In-Editor session")), FText());
+						})
+					);
+
+					ShowMenuBuilder.BeginSection("RenderDocPresets", LOCTEXT("PresetsSection", "Capture Presets"));
+					for (const FRenderDocPluginPreset& Preset : FRenderDocPluginPresets::Get())
+					{
+						const FString PresetName = Preset.Name;
+						const FString PresetLabel = Preset.Label;
+						ShowMenuBuilder.AddMenuEntry(
+							TAttribute<FText>::Create(TAttribute<FText>::FGetter::CreateLambda([PresetName, PresetLabel]()
+							{
+								// Evaluated while the menu is open, so the numbers include the latest captures:
+								return(FText::FromString(FString::Printf(TEXT("%s (%s)"), *PresetLabel, *FRenderDocPluginPresets::DescribeStats(PresetName))));
+							})),
+							FText::FromString(Preset.Description),
+							FSlateIcon(),
+							FUIAction(
+								FExecuteAction::CreateLambda([RenderDocSettings, PresetName]() { FRenderDocPluginPresets::Apply(PresetName, *RenderDocSettings); }),
+								FCanExecuteAction(),
+								FIsActionChecked::CreateLambda([RenderDocSettings, PresetName]() { return(RenderDocSettings->Preset == PresetName); })
+							),
+							NAME_None,
+							EUserInterfaceActionType::RadioButton
+						);
+					}
+					ShowMenuBuilder.EndSection();
+
+					ShowMenuBuilder.BeginSection("RenderDocAdvancedOptions", LOCTEXT("AdvancedOptionsSection", "Advanced Capture Options"));
+					auto AddOptionEntry = [&ShowMenuBuilder, RenderDocSettings](const FText& Label, const FText& ToolTip, bool* Option)
+					{
+						ShowMenuBuilder.AddMenuEntry(Label, ToolTip, FSlateIcon(),
+							FUIAction(
+								FExecuteAction::CreateLambda([RenderDocSettings, Option]() { *Option = !*Option; RenderDocSettings->Preset = TEXT("Custom"); }),
+								FCanExecuteAction(),
+								FIsActionChecked::CreateLambda([Option]() { return(*Option); })
+							),
+							NAME_None,
+							EUserInterfaceActionType::ToggleButton
+						);
+					};
+					AddOptionEntry(LOCTEXT("CallstacksOnlyDraws", "Callstacks On Draws Only"),
+						LOCTEXT("CallstacksOnlyDraws_ToolTip", "When capturing call stacks, only capture them for draw calls."),
+						&RenderDocSettings->bCaptureCallStacksOnlyDraws);
+					AddOptionEntry(LOCTEXT("CaptureAllCmdLists", "Capture All Command Lists"),
+						LOCTEXT("CaptureAllCmdLists_ToolTip", "Record all command lists from their creation, even those submitted outside of the captured frame (needed for deferred contexts)."),
+						&RenderDocSettings->bCaptureAllCmdLists);
+					AddOptionEntry(LOCTEXT("VerifyMapWrites", "Verify Map Writes"),
+						LOCTEXT("VerifyMapWrites_ToolTip", "Check for writes out of the bounds of mapped buffers (slower captures)."),
+						&RenderDocSettings->bVerifyMapWrites);
+					AddOptionEntry(LOCTEXT("APIValidation", "API Validation"),
+						LOCTEXT("APIValidation_ToolTip", "Enable the graphics API debug/validation layer; takes effect the next time the editor starts."),
+						&RenderDocSettings->bAPIValidation);
+					AddOptionEntry(LOCTEXT("AllowVSync", "Allow VSync"),
+						LOCTEXT("AllowVSync_ToolTip", "Let the application enable vertical sync; takes effect the next time the editor starts."),
+						&RenderDocSettings->bAllowVSync);
+					ShowMenuBuilder.EndSection();
 
 					ShowMenuBuilder.AddWidget(
 						SNew(SVerticalBox)
@@ -323,8 +405,17 @@ void SRenderDocPluginToolbar::BindCommands(FRenderDocPluginModule* ThePlugin, FR
 	);
 
 	CommandList->MapAction(
-		Commands.Settings_CaptureCallstack,
+		Commands.Settings_DeferredViewportCapture,
 		FExecuteAction::CreateLambda([](bool* flag) { *flag = !*flag; },
+			&Settings->bDeferredViewportCapture),
+		FCanExecuteAction(),
+		FIsActionChecked::CreateLambda([](const bool* flag) { return(*flag); },
+			&Settings->bDeferredViewportCapture)
+	);
+
+	CommandList->MapAction(
+		Commands.Settings_CaptureCallstack,
+		FExecuteAction::CreateLambda([Settings](bool* flag) { *flag = !*flag; Settings->Preset = TEXT("Custom"); },
 			&Settings->bCaptureCallStacks),
 		FCanExecuteAction(),
 		FIsActionChecked::CreateLambda([](const bool* flag) { return(*flag); },
@@ -333,7 +424,7 @@ void SRenderDocPluginToolbar::BindCommands(FRenderDocPluginModule* ThePlugin, FR
 
 	CommandList->MapAction(
 		Commands.Settings_CaptureAllResources,
-		FExecuteAction::CreateLambda([](bool* flag) { *flag = !*flag; },
+		FExecuteAction::CreateLambda([Settings](bool* flag) { *flag = !*flag; Settings->Preset = TEXT("Custom"); },
 			&Settings->bRefAllResources),
 		FCanExecuteAction(),
 		FIsActionChecked::CreateLambda([](const bool* flag) { return(*flag); },
@@ -342,12 +433,21 @@ void SRenderDocPluginToolbar::BindCommands(FRenderDocPluginModule* ThePlugin, FR
 
 	CommandList->MapAction(
 		Commands.Settings_SaveAllInitialState,
-		FExecuteAction::CreateLambda([](bool* flag) { *flag = !*flag; },
+		FExecuteAction::CreateLambda([Settings](bool* flag) { *flag = !*flag; Settings->Preset = TEXT("Custom"); },
 			&Settings->bSaveAllInitials),
 		FCanExecuteAction(),
 		FIsActionChecked::CreateLambda([](const bool* flag) { return(*flag); },
 			&Settings->bSaveAllInitials)
 	);
+
+	CommandList->MapAction(
+		Commands.Settings_UseCaptureStore,
+		FExecuteAction::CreateLambda([](bool* flag) { *flag = !*flag; },
+			&Settings->bUseCaptureStore),
+		FCanExecuteAction(),
+		FIsActionChecked::CreateLambda([](const bool* flag) { return(*flag); },
+			&Settings->bUseCaptureStore)
+	);
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -24,29 +24,51 @@
 
 #pragma once
 
-#include "InputDevice.h"
+#include "ModuleManager.h"
 
 
 /**
-* The RenderDoc plugin has been redesigned as an input plugin. Regular plugins built upon
-* IModuleInterface lack the ability of ticking, while IInputDeviceModule instantiates and
-* manages an IInputDevice object that is capable of ticking.
-*
-* By responding to tick events, the RenderDoc plugin is able to intercept the entire frame
-* activity, including Editor (Slate) UI rendering and SceneCapture updates; older versions
-* of the RenderDoc plugin were limited to capturing particular viewports only.
-*
-* This public interface wrapper appears to be mandatory for input device plugins/modules.
-* Without this public wrapper, the input device (IInputDevice) associated with the plugin
-* will not be instantiated during engine/application startup time.
+* The RenderDoc plugin follows the engine frame boundaries (FCoreDelegates::OnBeginFrame
+* and OnEndFrame) rather than ticking from a particular viewport, so it is able to
+* intercept the entire frame activity, including Editor (Slate) UI rendering and
+* SceneCapture updates; older versions of the RenderDoc plugin were limited to capturing
+* particular viewports only.
 */
 
 
+/**
+* Everything known about a capture at the time a lifecycle delegate is invoked (see
+* IRenderDocPlugin::OnCaptureRequested() and friends); fields not known yet are left
+* empty, or set to -1.
+*/
+struct FRenderDocCaptureInfo
+{
+	FString Preset;             // capture preset the options came from ("Custom" once edited)
+	FString Options;            // RenderDoc capture options in effect, as "Name=Value" pairs
+	uint64 RequestedFrame;      // engine frame (GFrameCounter) during which the capture was requested
+	int64 FirstRenderFrame;     // render frames (GFrameNumberRenderThread) at the capture boundaries
+	int64 LastRenderFrame;
+	double BeginSeconds;        // time spent in StartFrameCapture()
+	double EndSeconds;          // time spent in EndFrameCapture(), mostly writing the capture file
+	double CaptureSeconds;      // from the start to the end of the capture
+	FString CaptureFile;        // full path of the capture, once finished
+	int64 SizeBytes;
+	FString FailureReason;
+
+	FRenderDocCaptureInfo()
+		: RequestedFrame(0), FirstRenderFrame(-1), LastRenderFrame(-1)
+		, BeginSeconds(-1.0), EndSeconds(-1.0), CaptureSeconds(-1.0), SizeBytes(-1)
+	{ }
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnRenderDocCapture, const FRenderDocCaptureInfo&);
+
+
 /**
 * The public interface to this module.  In most cases, this interface is only public to sibling modules
 * within this plugin.
 */
-class IRenderDocPlugin : public IInputDeviceModule
+class IRenderDocPlugin : public IModuleInterface
 {
 public:
 
@@ -70,4 +92,87 @@ public:
 	{
 		return FModuleManager::Get().IsModuleLoaded("RenderDocPlugin");
 	}
+
+	/**
+	* Returns the module interface if the module is loaded, or NULL otherwise; unlike Get(),
+	* it never loads the module. Safe to call from the render thread as long as no module is
+	* being loaded or unloaded concurrently.
+	*/
+	static inline IRenderDocPlugin* GetIfLoaded()
+	{
+		return FModuleManager::GetModulePtr< IRenderDocPlugin >("RenderDocPlugin");
+	}
+
+	/**
+	* True if RenderDoc has been injected in the process and captures can be taken.
+	*/
+	virtual bool IsCaptureAvailable() const = 0;
+
+	/**
+	* Starts capturing an arbitrary region of rendering work (a single SceneCapture update,
+	* a compute dispatch, a render target bake...), which is much smaller and faster to
+	* inspect than an entire frame. Callable from the game thread (the request is then
+	* enqueued to the render thread, in order with the rendering commands issued around
+	* it) or directly from the render thread. Nested regions are folded into the outermost
+	* one, and a region that starts while another capture is in progress is ignored.
+	*
+	* @param Label Optional name prepended to the capture file name.
+	*/
+	virtual void BeginScopedCapture(const TCHAR* Label = NULL) = 0;
+
+	/**
+	* Ends the region started by BeginScopedCapture(), from the same thread that started it.
+	* The capture is then handled like any other one (stats, archiving, replay UI).
+	*/
+	virtual void EndScopedCapture() = 0;
+
+	/**
+	* Capture lifecycle: a capture has been requested, RenderDoc started capturing, the
+	* capture file has reached its final location, or the capture failed (or was refused,
+	* e.g. by the memory guard). Every delegate is broadcast on the game thread, never on
+	* the render or RHI threads, shortly after the fact; they cover every kind of capture
+	* (frame, viewport, range, scoped...).
+	*/
+	virtual FOnRenderDocCapture& OnCaptureRequested() = 0;
+	virtual FOnRenderDocCapture& OnCaptureStarted() = 0;
+	virtual FOnRenderDocCapture& OnCaptureFinished() = 0;
+	virtual FOnRenderDocCapture& OnCaptureFailed() = 0;
+};
+
+
+/**
+* Captures the rendering work issued during its lifetime; does nothing when the RenderDoc
+* plugin is not loaded or when RenderDoc has not been injected in the process:
+*
+*   {
+*     FScopedRenderDocCapture Capture (TEXT("LightmapBake"));
+*     ...
+*   }
+*/
+class FScopedRenderDocCapture
+{
+public:
+	explicit FScopedRenderDocCapture(const TCHAR* Label = NULL)
+		: Plugin(IRenderDocPlugin::GetIfLoaded())
+	{
+		if (Plugin && !Plugin->IsCaptureAvailable())
+			Plugin = NULL;
+		if (Plugin)
+			Plugin->BeginScopedCapture(Label);
+	}
+
+	~FScopedRenderDocCapture()
+	{
+		if (Plugin)
+			Plugin->EndScopedCapture();
+	}
+
+private:
+	FScopedRenderDocCapture(const FScopedRenderDocCapture&);
+	FScopedRenderDocCapture& operator=(const FScopedRenderDocCapture&);
+
+	IRenderDocPlugin* Plugin;
 };
+
+/** Captures the remainder of the enclosing scope: RENDERDOC_SCOPED_CAPTURE(TEXT("Bake")); */
+#define RENDERDOC_SCOPED_CAPTURE(Label) FScopedRenderDocCapture ANONYMOUS_VARIABLE(RenderDocScopedCapture_)(Label)
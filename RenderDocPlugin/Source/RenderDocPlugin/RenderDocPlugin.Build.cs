@@ -30,7 +30,14 @@ namespace UnrealBuildTool.Rules
 	{
 		public RenderDocPlugin(TargetInfo Target)
 		{
-			PrivateDependencyModuleNames.AddRange(new string[] { });
+			// Native window handles and the window title of the HUD come from Slate, but
+			// Test builds do without it (the RHI viewport has the native window too):
+			bool bUseSlate = UEBuildConfiguration.bBuildEditor || Target.Configuration != UnrealTargetConfiguration.Test;
+			if (bUseSlate)
+			{
+				PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
+			}
+			Definitions.Add("RENDERDOC_PLUGIN_SLATE=" + (bUseSlate ? "1" : "0"));
 
 			PublicIncludePaths.AddRange(new string[] { "RenderDocPlugin/Public" });
 			PrivateIncludePaths.AddRange(new string[] { "RenderDocPlugin/Private" });
@@ -40,18 +47,58 @@ namespace UnrealBuildTool.Rules
 				 "Core"
 				,"CoreUObject"
 				,"Engine"
-				,"InputCore"
-				,"DesktopPlatform"
+			});
+
+			// Everything else stays private, so that the modules depending on this one
+			// (for scoped captures) do not inherit it:
+			PrivateDependencyModuleNames.AddRange(new string[]
+			{
+				 "InputCore"
 				,"Projects"
 				,"RenderCore"
-				,"InputDevice"
+				,"Json"				// flythrough manifests
 				,"RHI"				// RHI module: required for accessing the UE4 flag GUsingNullRHI.
 			});
 
+			// Shipping builds never use RenderDoc (newer engines do not even build the
+			// module for them, see RenderDocPlugin.uplugin), so the features below, and
+			// what they depend on, are left out of them:
+			bool bShipping = Target.Configuration == UnrealTargetConfiguration.Shipping;
+			bool bServer = Target.Type == TargetRules.TargetType.Server;
+
+			// Sequencer frame captures; dedicated servers render no sequence:
+			bool bWithSequencer = !bShipping && !bServer;
+			if (bWithSequencer)
+			{
+				PrivateDependencyModuleNames.AddRange(new string[] { "LevelSequence", "MovieScene", "MovieSceneTracks" });
+			}
+			Definitions.Add("RENDERDOC_PLUGIN_SEQUENCER=" + (bWithSequencer ? "1" : "0"));
+
+			// Synchronized multi-process captures; dedicated servers take part in them:
+			bool bWithSync = !bShipping;
+			if (bWithSync)
+			{
+				PrivateDependencyModuleNames.AddRange(new string[] { "Sockets", "Networking" });
+			}
+			Definitions.Add("RENDERDOC_PLUGIN_SYNC=" + (bWithSync ? "1" : "0"));
+
+			// Native device and window handles of the OpenGL RHI (current context), and of
+			// Linux windows (SDL windows drawn to X11 windows):
+			bool bWithOpenGL = !bShipping && !bServer;
+			if (bWithOpenGL)
+			{
+				AddEngineThirdPartyPrivateStaticDependencies(Target, "OpenGL");
+				if (Target.Platform == UnrealTargetPlatform.Linux)
+				{
+					AddEngineThirdPartyPrivateStaticDependencies(Target, "SDL2");
+				}
+			}
+			Definitions.Add("RENDERDOC_PLUGIN_OPENGL=" + (bWithOpenGL ? "1" : "0"));
+
 			if (UEBuildConfiguration.bBuildEditor == true)
 			{
 				DynamicallyLoadedModuleNames.AddRange(new string[] { "LevelEditor" });
-				PublicDependencyModuleNames.AddRange(new string[]
+				PrivateDependencyModuleNames.AddRange(new string[]
 				{
 					 "Slate"
 					,"SlateCore"
@@ -59,6 +106,7 @@ namespace UnrealBuildTool.Rules
 					,"UnrealEd"
 					,"MainFrame"
 					,"GameProjectGeneration"
+					,"DesktopPlatform"		// only needed for prompting the user for a RenderDoc installation
 				});
 			}
 		}